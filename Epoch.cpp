@@ -0,0 +1,95 @@
+#include "Epoch.h"
+#include <thread>
+
+using namespace std;
+
+EpochManager& EpochManager::instance() {
+    static EpochManager em;
+    return em;
+}
+
+/**
+ * 领取一条登记记录: 优先复用已退出线程的记录,否则新建并挂到链表头
+ */
+EpochManager::ThreadRecord* EpochManager::acquireRecord() {
+    for (ThreadRecord* r = records.load(); r; r = r->next) {
+        bool expected = false;
+        if (r->inUse.compare_exchange_strong(expected, true)) {
+            return r;
+        }
+    }
+
+    ThreadRecord* r = new ThreadRecord();
+    ThreadRecord* head = records.load();
+    do {
+        r->next = head;
+    } while (!records.compare_exchange_weak(head, r));
+    return r;
+}
+
+/**
+ * 当前线程的登记记录,线程退出时自动归还
+ */
+EpochManager::ThreadRecord* EpochManager::localRecord() {
+    struct Holder {
+        ThreadRecord* record = nullptr;
+        ~Holder() {
+            if (record) {
+                record->epoch.store(0);
+                record->depth = 0;
+                record->inUse.store(false);
+            }
+        }
+    };
+    static thread_local Holder holder;
+    if (!holder.record) {
+        holder.record = acquireRecord();
+    }
+    return holder.record;
+}
+
+/**
+ * 进入临界区: 最外层时登记当前全局纪元
+ */
+void EpochManager::enter() {
+    ThreadRecord* r = localRecord();
+    if (r->depth++ == 0) {
+        r->epoch.store(globalEpoch.load());
+    }
+}
+
+/**
+ * 退出临界区: 最外层时清除登记
+ */
+void EpochManager::exit() {
+    ThreadRecord* r = localRecord();
+    if (--r->depth == 0) {
+        r->epoch.store(0);
+    }
+}
+
+/**
+ * 所有活跃读者都已登记当前纪元 e 时,把全局纪元推进到 e + 1
+ */
+bool EpochManager::tryAdvance() {
+    uint64_t e = globalEpoch.load();
+    for (ThreadRecord* r = records.load(); r; r = r->next) {
+        uint64_t re = r->epoch.load();
+        if (re != 0 && re != e) {
+            return false;
+        }
+    }
+    return globalEpoch.compare_exchange_strong(e, e + 1);
+}
+
+/**
+ * 推进两个纪元: 调用前已在临界区内的读者此时必然已经退出
+ */
+void EpochManager::synchronize() {
+    uint64_t target = globalEpoch.load() + 2;
+    while (globalEpoch.load() < target) {
+        if (!tryAdvance()) {
+            this_thread::yield();
+        }
+    }
+}
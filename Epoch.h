@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+using namespace std;
+
+/**
+ * EpochManager
+ * 基于纪元(epoch)的延迟回收,供无锁读者使用:
+ *  - 读者进入临界区时登记当前全局纪元,退出时清除登记,全程不加锁
+ *  - 回收者把要释放的资源标记为“在纪元 e 退休”,全局纪元推进到 e + 2 后,
+ *    所有可能看到该资源的读者都已退出,此时才真正回收
+ *  - synchronize() 阻塞等待当前所有读者退出,供必须立即复用资源的场合使用
+ *
+ * 全进程共用一个实例,每个线程在首次进入时领取一条登记记录,线程退出时归还。
+ */
+class EpochManager {
+public:
+    static EpochManager& instance();
+
+    /**
+     * 进入/退出读临界区(可嵌套)
+     */
+    void enter();
+    void exit();
+
+    /**
+     * 当前全局纪元,用于给退休资源打标记
+     */
+    uint64_t currentEpoch() const { return globalEpoch.load(); }
+
+    /**
+     * 在 retireEpoch 退休的资源现在是否可以回收
+     */
+    bool isSafe(uint64_t retireEpoch) const { return globalEpoch.load() >= retireEpoch + 2; }
+
+    /**
+     * 尝试推进全局纪元(所有活跃读者都已登记当前纪元时才成功),不阻塞
+     */
+    bool tryAdvance();
+
+    /**
+     * 阻塞直到调用前已进入临界区的读者全部退出
+     * 注意: 调用者自己不能处于临界区中
+     */
+    void synchronize();
+
+    // 每个线程的登记记录,只追加不释放,线程退出后可被复用
+    struct ThreadRecord {
+        atomic<uint64_t> epoch;     // 0 表示不在临界区
+        atomic<bool> inUse;
+        size_t depth;
+        ThreadRecord* next;
+
+        ThreadRecord() : epoch(0), inUse(true), depth(0), next(nullptr) {}
+    };
+
+private:
+    EpochManager() : globalEpoch(1), records(nullptr) {}
+
+    ThreadRecord* acquireRecord();
+    ThreadRecord* localRecord();
+
+    atomic<uint64_t> globalEpoch;
+    atomic<ThreadRecord*> records;
+};
+
+/**
+ * RAII 读临界区
+ */
+class EpochGuard {
+public:
+    explicit EpochGuard(EpochManager& em) : em(em) { em.enter(); }
+    ~EpochGuard() { em.exit(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+private:
+    EpochManager& em;
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * 空闲帧树
+ * 按帧号建立的线段树,每个叶子表示一帧是否空闲,内部节点汇总其区间的:
+ *  - 空闲帧数、开头/结尾的连续空闲帧数、最长连续空闲帧数、空闲段数
+ * 因此:
+ *  - 分配/释放一帧只需 O(log n) 更新
+ *  - 最低空闲帧、最高在用帧可 O(log n) 找到(分配和整理都用)
+ *  - 碎片统计(最长连续空闲、空闲段数)直接从根节点读出,不需要扫描
+ */
+class FreeFrameTree {
+public:
+    explicit FreeFrameTree(size_t frameCount) : base(1) {
+        while (base < frameCount) {
+            base <<= 1;
+        }
+        nodes.assign(base * 2, Node());
+        for (size_t f = 0; f < frameCount; ++f) {
+            nodes[base + f] = leaf(true);
+        }
+        for (size_t i = base; i-- > 1;) {
+            nodes[i] = combine(nodes[2 * i], nodes[2 * i + 1]);
+        }
+    }
+
+    // 空闲帧数
+    size_t size() const { return nodes[1].free; }
+    bool empty() const { return nodes[1].free == 0; }
+
+    bool isFree(size_t frameNumber) const { return nodes[base + frameNumber].free != 0; }
+
+    // 标记一帧为空闲/在用
+    void release(size_t frameNumber) { set(frameNumber, true); }
+    void take(size_t frameNumber) { set(frameNumber, false); }
+
+    // 取出编号最低的空闲帧,没有空闲帧时返回 false
+    bool allocate(size_t& frameNumber) {
+        if (empty()) {
+            return false;
+        }
+        size_t i = 1;
+        while (i < base) {
+            i = nodes[2 * i].free ? 2 * i : 2 * i + 1;
+        }
+        frameNumber = i - base;
+        take(frameNumber);
+        return true;
+    }
+
+    // 编号最高的在用帧,全部空闲时返回 false
+    bool lastUsed(size_t& frameNumber) const {
+        if (nodes[1].free == nodes[1].len) {
+            return false;
+        }
+        size_t i = 1;
+        while (i < base) {
+            const Node& right = nodes[2 * i + 1];
+            i = right.len > right.free ? 2 * i + 1 : 2 * i;
+        }
+        frameNumber = i - base;
+        return true;
+    }
+
+    size_t largestRun() const { return nodes[1].best; }
+    size_t runs() const { return nodes[1].runs; }
+
+    // 空闲帧是否已全部连在高端
+    bool isCompacted() const { return nodes[1].suffix == nodes[1].free; }
+
+private:
+    struct Node {
+        size_t len = 0;     // 区间内的帧数(补齐用的叶子为0)
+        size_t free = 0;    // 空闲帧数
+        size_t prefix = 0;  // 开头的连续空闲帧数
+        size_t suffix = 0;  // 结尾的连续空闲帧数
+        size_t best = 0;    // 最长连续空闲帧数
+        size_t runs = 0;    // 空闲段数
+    };
+
+    static Node leaf(bool isFree) {
+        Node n;
+        n.len = 1;
+        n.free = n.prefix = n.suffix = n.best = n.runs = isFree ? 1 : 0;
+        return n;
+    }
+
+    static Node combine(const Node& a, const Node& b) {
+        if (a.len == 0) {
+            return b;
+        }
+        if (b.len == 0) {
+            return a;
+        }
+        Node n;
+        n.len = a.len + b.len;
+        n.free = a.free + b.free;
+        n.prefix = a.prefix == a.len ? a.len + b.prefix : a.prefix;
+        n.suffix = b.suffix == b.len ? b.len + a.suffix : b.suffix;
+        n.best = max(max(a.best, b.best), a.suffix + b.prefix);
+        n.runs = a.runs + b.runs - (a.suffix && b.prefix ? 1 : 0);
+        return n;
+    }
+
+    void set(size_t frameNumber, bool isFree) {
+        size_t i = base + frameNumber;
+        nodes[i] = leaf(isFree);
+        for (i >>= 1; i; i >>= 1) {
+            nodes[i] = combine(nodes[2 * i], nodes[2 * i + 1]);
+        }
+    }
+
+    size_t base;            // 叶子层起始下标(不小于帧数的2的幂)
+    vector<Node> nodes;     // nodes[1] 为根,nodes[i] 的子节点为 2i 与 2i+1
+};
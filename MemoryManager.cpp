@@ -1,40 +1,63 @@
 #include "MemoryManager.h"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <xmmintrin.h>   // _mm_prefetch
+#endif
 
 using namespace std;
 
 /**
  * 构造函数:
  *  - 初始化物理内存(全部清0)
- *  - 初始化空闲帧列表(0 ~ frameCount-1)
+ *  - 初始化空闲帧树(0 ~ frameCount-1 全部空闲)
  */
 MemoryManager::MemoryManager(size_t pageSizeBytes, size_t numFrames)
     : pageSize(pageSizeBytes),
+    pageShift(0),
+    pageClass(PageSizeClass::Arbitrary),
     frameCount(numFrames),
-    physicalMemory(pageSizeBytes* numFrames, 0) {
-    freeFrames.reserve(numFrames);
-    for (size_t i = 0; i < numFrames; ++i) {
-        freeFrames.push_back(i);
+    physicalMemory(pageSizeBytes* numFrames, 0),
+    freeFrames(numFrames),
+    frameOwner(numFrames, PageRef{ static_cast<size_t>(-1), 0 }),
+    frameHot(new atomic<uint8_t>[numFrames]()) {
+    // 不同实例的代号区间互不重叠,避免线程缓存把新实例误认成旧实例
+    static atomic<uint64_t> generationSeed(0);
+    layoutGeneration = generationSeed.fetch_add(static_cast<uint64_t>(1) << 40);
+
+    // 根据页大小选择页几何策略,地址转换时按此分派
+    if (pageSize != 0 && (pageSize & (pageSize - 1)) == 0) {
+        while ((static_cast<size_t>(1) << pageShift) < pageSize) {
+            ++pageShift;
+        }
+        switch (pageSize) {
+        case 1024:    pageClass = PageSizeClass::Page1K; break;
+        case 4096:    pageClass = PageSizeClass::Page4K; break;
+        case 65536:   pageClass = PageSizeClass::Page64K; break;
+        case 2097152: pageClass = PageSizeClass::Page2M; break;
+        default:      pageClass = PageSizeClass::PowerOfTwo; break;
+        }
     }
 }
 
 /**
  * 分配一个空闲物理帧(线程安全内部调用,需在外部加锁或只在类方法内调用)
+ *  - 总是取编号最低的空闲帧
+ *  - 空闲帧用完时先回收退休帧(必要时等待读者退出)
  */
 bool MemoryManager::allocateFrame(size_t& frameNumber) {
     if (freeFrames.empty()) {
-        return false;
+        reclaimRetiredLocked(true);
     }
-    frameNumber = freeFrames.back();
-    freeFrames.pop_back();
-    return true;
+    return freeFrames.allocate(frameNumber);
 }
 
 /**
  * 计算需要的页数(向上取整)
  */
 size_t MemoryManager::calcNumPages(size_t segmentSizeBytes) const {
-    return (segmentSizeBytes + pageSize - 1) / pageSize;
+    return withGeometry([&](const auto& geo) { return geo.numPages(segmentSizeBytes); });
 }
 
 /**
@@ -42,32 +65,73 @@ size_t MemoryManager::calcNumPages(size_t segmentSizeBytes) const {
  * shared=true 表示共享段,
  * shared=false 表示普通私有段。
  */
-size_t MemoryManager::createSegment(size_t segmentSizeBytes, bool shared) {
+size_t MemoryManager::createSegment(size_t segmentSizeBytes, bool shared, int ownerId) {
     lock_guard<mutex> lock(mtx); // 整个创建过程加锁,防止并发干扰
+    return createSegmentLocked(segmentSizeBytes, shared, ownerId);
+}
 
+/**
+ * 创建段的实际实现(需已持有 mtx)
+ *  - 所属进程设置了驻留上限时,页表项全部按需分配,由缺页处理受上限约束
+ *  - 否则与原来一样立即为每页分配物理帧,并清0
+ */
+size_t MemoryManager::createSegmentLocked(size_t segmentSizeBytes, bool shared, int ownerId) {
     size_t numPages = calcNumPages(segmentSizeBytes);
-    if (numPages > freeFrames.size()) {
+
+    auto rsIt = residentSets.find(ownerId);
+    bool demandPaged = rsIt != residentSets.end() && rsIt->second.limitFrames != 0;
+    if (!demandPaged && numPages > freeFrames.size()) {
+        reclaimRetiredLocked(true);
+    }
+    if (!demandPaged && numPages > freeFrames.size()) {
         cerr << "[MemoryManager] Failed to create segment: not enough frames." << endl;
         return static_cast<size_t>(-1);
     }
 
+    // 段号总是新分配,不复用(旧段号可能仍被进程或句柄持有);只复用已销毁段的页表存储
+    size_t pageTableIndex = pageTables.size();
+    bool reusePageTable = !freePageTables.empty();
+    if (reusePageTable) {
+        pageTableIndex = freePageTables.back();
+        freePageTables.pop_back();
+    }
+
     // 创建页表并为每页分配物理帧
     PageTable pt(numPages);
-    for (size_t i = 0; i < numPages; ++i) {
+    for (size_t i = 0; i < numPages && !demandPaged; ++i) {
         size_t frameNumber;
         if (!allocateFrame(frameNumber)) {
             // 按理说不会到这里,因为前面已经检查过
             cerr << "[MemoryManager] Unexpected: no free frame during createSegment." << endl;
+            if (reusePageTable) {
+                freePageTables.push_back(pageTableIndex);
+            }
             return static_cast<size_t>(-1);
         }
+        // 回收来的帧可能残留其他段的数据,与缺页处理一样先清0
+        auto frameBegin = physicalMemory.begin() + frameNumber * pageSize;
+        fill(frameBegin, frameBegin + pageSize, 0);
+
         PageTableEntry* entry = pt.getEntry(i);
         entry->present = true;
         entry->frameNumber = frameNumber;
+        frameOwner[frameNumber] = { pageTableIndex, i };
+        frameHot[frameNumber].store(0, memory_order_relaxed);
+
+        if (ownerId >= 0) {
+            ResidentSet& rs = residentSets[ownerId];
+            rs.resident++;
+            enqueueClockLocked(rs, pageTableIndex, i, entry);
+        }
     }
 
-    // 将页表加入全局页表数组
-    size_t pageTableIndex = pageTables.size();
-    pageTables.push_back(pt);
+    // 将页表加入全局页表数组(复用已回收的页表位置时直接替换)
+    if (reusePageTable) {
+        pageTables[pageTableIndex] = pt;
+    }
+    else {
+        pageTables.push_back(pt);
+    }
 
     // 构造段表项
     SegmentDescriptor desc;
@@ -76,12 +140,146 @@ size_t MemoryManager::createSegment(size_t segmentSizeBytes, bool shared) {
     desc.pageTableIndex = pageTableIndex;
     desc.shared = shared;
     desc.refCount = 1; // 初始持有者计数为1
+    desc.owner = ownerId;
 
     // 放入全局段表,返回全局段号
-    size_t globalSegNo = segmentTable.addSegment(desc);
+    return segmentTable.addSegment(desc);
+}
+
+/**
+ * 创建栈式段:
+ *  - 页表第 i 项对应 [top - (i+1)*pageSize, top - i*pageSize)
+ *  - 这样向下增长同样只是在页表尾部追加
+ */
+size_t MemoryManager::createStackSegment(size_t initialSizeBytes, size_t maxSizeBytes, bool shared, int ownerId) {
+    lock_guard<mutex> lock(mtx);
+
+    size_t top = calcNumPages(maxSizeBytes) * pageSize;
+    if (initialSizeBytes > top || top > static_cast<size_t>(UINT32_MAX) + 1) {
+        cerr << "[MemoryManager] createStackSegment: invalid size." << endl;
+        return static_cast<size_t>(-1);
+    }
+
+    size_t globalSegNo = createSegmentLocked(initialSizeBytes, shared, ownerId);
+    if (globalSegNo == static_cast<size_t>(-1)) {
+        return globalSegNo;
+    }
+    SegmentDescriptor* seg = segmentTable.getSegment(globalSegNo);
+    seg->growsDown = true;
+    seg->top = top;
     return globalSegNo;
 }
 
+/**
+ * 原地调整段大小:
+ *  - 增长时只追加 present=false 的页表项,首次写入时再分配帧(按需分配)
+ *  - 缩小时回收尾部页的帧,并把保留的最后一页中越界部分清0,
+ *    保证之后再次增长时读到的是0而不是旧数据
+ */
+bool MemoryManager::resizeSegment(size_t globalSegNo, size_t newSizeBytes) {
+    lock_guard<mutex> lock(mtx);
+    return resizeSegmentLocked(globalSegNo, newSizeBytes, "resizeSegment");
+}
+
+/**
+ * 按增量调整段大小: 读取当前大小与调整在同一临界区内完成,并发调用不会丢失增量
+ */
+bool MemoryManager::resizeSegmentBy(size_t globalSegNo, ptrdiff_t deltaBytes, size_t& newSizeBytes) {
+    lock_guard<mutex> lock(mtx);
+
+    const SegmentDescriptor* seg = segmentTable.getSegment(globalSegNo);
+    if (!seg || !seg->valid) {
+        cerr << "[MemoryManager] resizeSegmentBy: invalid segment " << globalSegNo << endl;
+        return false;
+    }
+    if (deltaBytes < 0 && static_cast<size_t>(-deltaBytes) > seg->limit) {
+        cerr << "[MemoryManager] resizeSegmentBy: shrink below zero." << endl;
+        return false;
+    }
+
+    newSizeBytes = seg->limit + deltaBytes;
+    return resizeSegmentLocked(globalSegNo, newSizeBytes, "resizeSegmentBy");
+}
+
+/**
+ * 调整段大小的实际实现(需已持有 mtx)
+ *  - 被其他进程挂接的共享段不允许缩小,避免截掉对方仍在使用的页
+ *    (共享内存引用计数 refCount 或进程映射数 attachCount 大于1)
+ */
+bool MemoryManager::resizeSegmentLocked(size_t globalSegNo, size_t newSizeBytes, const char* caller) {
+    SegmentDescriptor* seg = segmentTable.getSegment(globalSegNo);
+    if (!seg || !seg->valid) {
+        cerr << "[MemoryManager] " << caller << ": invalid segment " << globalSegNo << endl;
+        return false;
+    }
+
+    if (newSizeBytes < seg->limit && seg->shared && (seg->refCount > 1 || seg->attachCount > 1)) {
+        cerr << "[MemoryManager] " << caller << ": cannot shrink shared segment still attached elsewhere." << endl;
+        return false;
+    }
+
+    size_t maxSize = seg->growsDown ? seg->top : static_cast<size_t>(UINT32_MAX) + 1;
+    if (newSizeBytes > maxSize) {
+        cerr << "[MemoryManager] " << caller << ": new size exceeds segment maximum." << endl;
+        return false;
+    }
+
+    if (seg->pageTableIndex >= pageTables.size()) {
+        cerr << "[MemoryManager] " << caller << ": invalid pageTableIndex." << endl;
+        return false;
+    }
+    PageTable& pt = pageTables[seg->pageTableIndex];
+
+    size_t oldPages = pt.size();
+    size_t newPages = calcNumPages(newSizeBytes);
+
+    // 界限变化要让原子操作的线程缓存失效(缓存中记有合法偏移范围):
+    //  - 缩小时还要等待快速路径退出,否则旧界限会继续放行越界偏移,
+    //    或者在下面清0尾页之后再写入
+    //  - 栈式段增长时下界也会变化,只需使缓存失效
+    if (newSizeBytes < seg->limit) {
+        beginRemapLocked();
+    }
+    else if (seg->growsDown && newSizeBytes != seg->limit) {
+        layoutGeneration.fetch_add(1);
+    }
+
+    // 缩小: 回收被截掉的尾部页
+    for (size_t i = newPages; i < oldPages; ++i) {
+        releasePageLocked(*seg, pt.getEntry(i), i);
+    }
+    pt.resize(newPages);
+
+    // 清理保留的最后一页中超出新界限的字节
+    if (newSizeBytes < seg->limit && newPages > 0) {
+        PageTableEntry* last = pt.getEntry(newPages - 1);
+        size_t used = newSizeBytes - (newPages - 1) * pageSize;
+        uint8_t* frame = nullptr;
+        if (last->present) {
+            frame = &physicalMemory[last->frameNumber * pageSize];
+        }
+        else if (last->swapped) {
+            // 已换出的尾页直接在交换区中清理,不换回(换回可能失败或挤出别的页)
+            auto it = swapStore.find({ seg->pageTableIndex, newPages - 1 });
+            if (it != swapStore.end()) {
+                frame = it->second.data();
+            }
+        }
+        if (frame) {
+            if (seg->growsDown) {
+                // 栈式段的尾页位于低地址端,越界部分在页的开头
+                fill(frame, frame + (pageSize - used), 0);
+            }
+            else {
+                fill(frame + used, frame + pageSize, 0);
+            }
+        }
+    }
+
+    seg->limit = newSizeBytes;
+    return true;
+}
+
 /**
  * 销毁一个全局段:
  *  - 仅当 refCount == 0 时才真正释放
@@ -109,55 +307,338 @@ bool MemoryManager::destroySegment(size_t globalSegNo) {
 
     PageTable& pt = pageTables[seg->pageTableIndex];
     for (size_t i = 0; i < pt.size(); ++i) {
-        PageTableEntry* entry = pt.getEntry(i);
-        if (entry->present) {
-            freeFrames.push_back(entry->frameNumber);
-            entry->present = false;
-        }
+        releasePageLocked(*seg, pt.getEntry(i), i);
     }
 
-    // 将段标记为无效
+    // 将段标记为无效,段号不再复用;页表清空后留给新段
+    //  - 页表只在 mtx 下访问,CLOCK 队列中指向旧页的项因 clockTag 不符而失效
     seg->valid = false;
+    layoutGeneration.fetch_add(1);
+    pt.resize(0);
+    freePageTables.push_back(seg->pageTableIndex);
     return true;
 }
 
 /**
- * 使用全局段号 + 段内偏移 做地址转换
- * (内部工具函数,对外 translateGlobal 提供封装)
+ * 共享段引用计数加1
  */
-bool MemoryManager::translateGlobal(size_t globalSegNo, uint32_t offset, size_t& physicalAddress) const {
+bool MemoryManager::retainSegment(size_t globalSegNo, size_t& refCount) {
     lock_guard<mutex> lock(mtx);
 
-    // 1. 查段表
-    const SegmentDescriptor* segDesc = segmentTable.getSegment(globalSegNo);
-    if (!segDesc || !segDesc->valid) {
-        cerr << "[MemoryManager] translateGlobal: invalid segment " << globalSegNo << endl;
+    SegmentDescriptor* seg = segmentTable.getSegment(globalSegNo);
+    if (!seg || !seg->valid) {
+        cerr << "[MemoryManager] retainSegment: invalid segment " << globalSegNo << endl;
         return false;
     }
+    refCount = ++seg->refCount;
+    return true;
+}
+
+/**
+ * 记录/撤销一次进程映射
+ */
+bool MemoryManager::attachSegment(size_t globalSegNo) {
+    lock_guard<mutex> lock(mtx);
 
-    // 2. 段界限检查
-    if (offset >= segDesc->limit) {
-        cerr << "[MemoryManager] translateGlobal: offset out of range." << endl;
+    SegmentDescriptor* seg = segmentTable.getSegment(globalSegNo);
+    if (!seg || !seg->valid) {
+        cerr << "[MemoryManager] attachSegment: invalid segment " << globalSegNo << endl;
         return false;
     }
+    seg->attachCount++;
+    return true;
+}
+
+void MemoryManager::detachSegment(size_t globalSegNo) {
+    lock_guard<mutex> lock(mtx);
+
+    SegmentDescriptor* seg = segmentTable.getSegment(globalSegNo);
+    if (seg && seg->valid && seg->attachCount > 0) {
+        seg->attachCount--;
+    }
+}
 
-    // 3. 拆分页号+页内偏移
-    size_t pageNo = offset / pageSize;
-    size_t pageOffset = offset % pageSize;
+/**
+ * 共享段引用计数减1
+ */
+bool MemoryManager::releaseSegment(size_t globalSegNo, size_t& refCount) {
+    lock_guard<mutex> lock(mtx);
 
-    if (segDesc->pageTableIndex >= pageTables.size()) {
-        cerr << "[MemoryManager] translateGlobal: invalid pageTableIndex." << endl;
+    SegmentDescriptor* seg = segmentTable.getSegment(globalSegNo);
+    if (!seg || !seg->valid) {
+        cerr << "[MemoryManager] releaseSegment: invalid segment " << globalSegNo << endl;
         return false;
     }
-    const PageTable& pt = pageTables[segDesc->pageTableIndex];
+    if (seg->refCount == 0) {
+        cerr << "[MemoryManager] releaseSegment: refCount already 0." << endl;
+        return false;
+    }
+    refCount = --seg->refCount;
+    return true;
+}
+
+/**
+ * 软件预取(只是提示,不影响正确性)
+ */
+static inline void prefetchRead(const void* p) {
+#if defined(_MSC_VER)
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+    __builtin_prefetch(p);
+#endif
+}
+
+/**
+ * 查找有效段及其页表(需已持有 mtx)
+ */
+const PageTable* MemoryManager::findPageTableLocked(size_t globalSegNo, const SegmentDescriptor*& segDesc) const {
+    segDesc = segmentTable.getSegment(globalSegNo);
+    if (!segDesc || !segDesc->valid || segDesc->pageTableIndex >= pageTables.size()) {
+        return nullptr;
+    }
+    return &pageTables[segDesc->pageTableIndex];
+}
 
-    if (pageNo >= pt.size()) {
-        cerr << "[MemoryManager] translateGlobal: page number out of range." << endl;
+/**
+ * 查找偏移所在的页表项(需已持有 mtx)
+ *  - 按页大小分派到 lookupEntryImpl 的对应实例
+ */
+const PageTableEntry* MemoryManager::lookupEntryLocked(size_t globalSegNo, uint32_t offset,
+    const SegmentDescriptor*& segDesc, size_t& pageOffset, const char* caller) const {
+    const PageTable* pt = findPageTableLocked(globalSegNo, segDesc);
+    if (!pt) {
+        cerr << "[MemoryManager] " << caller << ": invalid segment " << globalSegNo << endl;
+        return nullptr;
+    }
+
+    const PageTableEntry* entry = nullptr;
+    TranslateStatus st = withGeometry([&](const auto& geo) {
+        return lookupEntryImpl(geo, *segDesc, *pt, offset, entry, pageOffset);
+        });
+    if (st == TranslateStatus::OutOfRange) {
+        cerr << "[MemoryManager] " << caller << ": offset out of range." << endl;
+        return nullptr;
+    }
+    return entry;
+}
+
+/**
+ * 页表项查找的实际实现
+ *  - 普通段: 页号 = offset / pageSize
+ *  - 栈式段: 页号从 top 往下数
+ */
+template <class Geometry>
+TranslateStatus MemoryManager::lookupEntryImpl(const Geometry& geo, const SegmentDescriptor& segDesc,
+    const PageTable& pt, uint32_t offset, const PageTableEntry*& entry, size_t& pageOffset) const {
+    // 段界限检查 + 拆分页号与页内偏移
+    size_t pageNo;
+    if (segDesc.growsDown) {
+        if (offset >= segDesc.top || offset < segDesc.top - segDesc.limit) {
+            return TranslateStatus::OutOfRange;
+        }
+        pageNo = geo.pageNo(segDesc.top - 1 - offset);
+    }
+    else {
+        if (offset >= segDesc.limit) {
+            return TranslateStatus::OutOfRange;
+        }
+        pageNo = geo.pageNo(offset);
+    }
+    pageOffset = geo.pageOffset(offset);
+
+    entry = pt.getEntry(pageNo);
+    return entry ? TranslateStatus::Ok : TranslateStatus::OutOfRange;
+}
+
+/**
+ * 缺页处理(需已持有 mtx):
+ *  - 通过 obtainFrameLocked 取得一帧(可能换出其他页)
+ *  - 被换出过的页从交换区换入,首次访问的页清0
+ */
+bool MemoryManager::faultInLocked(const SegmentDescriptor& seg, PageTableEntry* entry) {
+    size_t frameNumber;
+    if (!obtainFrameLocked(seg.owner, frameNumber)) {
         return false;
     }
 
-    const PageTableEntry* entry = pt.getEntry(pageNo);
-    if (!entry || !entry->present) {
+    size_t pageNo = static_cast<size_t>(entry - pageTables[seg.pageTableIndex].getEntry(0));
+    auto frameBegin = physicalMemory.begin() + frameNumber * pageSize;
+    if (entry->swapped) {
+        auto it = swapStore.find({ seg.pageTableIndex, pageNo });
+        copy(it->second.begin(), it->second.end(), frameBegin);
+        swapStore.erase(it);
+        entry->swapped = false;
+    }
+    else {
+        fill(frameBegin, frameBegin + pageSize, 0);
+    }
+    entry->frameNumber = frameNumber;
+    entry->present = true;
+    entry->referenced = true;
+    frameOwner[frameNumber] = { seg.pageTableIndex, pageNo };
+    frameHot[frameNumber].store(0, memory_order_relaxed);
+
+    if (seg.owner >= 0) {
+        ResidentSet& rs = residentSets[seg.owner];
+        rs.resident++;
+        rs.faults++;
+        enqueueClockLocked(rs, seg.pageTableIndex, pageNo, entry);
+    }
+    return true;
+}
+
+/**
+ * 记录一次访问(需已持有 mtx)
+ */
+void MemoryManager::noteAccessLocked(const SegmentDescriptor& seg, PageTableEntry* entry) {
+    entry->referenced = true;
+    if (seg.owner >= 0) {
+        residentSets[seg.owner].accesses++;
+    }
+}
+
+/**
+ * 为 ownerId 取得一帧(需已持有 mtx):
+ *  1. 进程已达驻留上限: 只从自己的页中换出(局部置换)
+ *  2. 有空闲帧: 直接分配
+ *  3. 全局无空闲帧: 选 reclaimPriority 最大的进程换出,
+ *     同优先级时选超出上限最多、其次驻留最多的进程
+ */
+bool MemoryManager::obtainFrameLocked(int ownerId, size_t& frameNumber) {
+    if (ownerId >= 0) {
+        ResidentSet& rs = residentSets[ownerId];
+        if (rs.limitFrames != 0 && rs.resident >= rs.limitFrames) {
+            return evictFromLocked(rs, frameNumber);
+        }
+    }
+
+    if (allocateFrame(frameNumber)) {
+        return true;
+    }
+
+    ResidentSet* victim = nullptr;
+    for (auto& kv : residentSets) {
+        ResidentSet& rs = kv.second;
+        if (rs.resident == 0) {
+            continue;
+        }
+        if (!victim || rs.reclaimPriority > victim->reclaimPriority) {
+            victim = &rs;
+            continue;
+        }
+        if (rs.reclaimPriority < victim->reclaimPriority) {
+            continue;
+        }
+        size_t over = rs.limitFrames != 0 && rs.resident > rs.limitFrames ? rs.resident - rs.limitFrames : 0;
+        size_t victimOver = victim->limitFrames != 0 && victim->resident > victim->limitFrames
+            ? victim->resident - victim->limitFrames : 0;
+        if (over > victimOver || (over == victimOver && rs.resident > victim->resident)) {
+            victim = &rs;
+        }
+    }
+    return victim && evictFromLocked(*victim, frameNumber);
+}
+
+/**
+ * 加入 CLOCK 队列(需已持有 mtx):
+ *  - 给页表项打上新的入队序号,同一页之前残留的队列项随之过期
+ *  - 队列长度超过驻留页数两倍时清除过期项,使队列长度与驻留页数同阶
+ */
+void MemoryManager::enqueueClockLocked(ResidentSet& rs, size_t pageTableIndex, size_t pageNo, PageTableEntry* entry) {
+    const size_t kClockSlack = 64;
+    if (rs.clock.size() > 2 * rs.resident + kClockSlack) {
+        deque<ClockRef> live;
+        for (const ClockRef& ref : rs.clock) {
+            if (clockEntryLocked(ref)) {
+                live.push_back(ref);
+            }
+        }
+        rs.clock.swap(live);
+    }
+
+    entry->clockTag = ++clockSeq;
+    rs.clock.push_back({ { pageTableIndex, pageNo }, entry->clockTag });
+}
+
+/**
+ * 队列项有效: 页表项存在、在内存中,且序号与入队时一致
+ */
+PageTableEntry* MemoryManager::clockEntryLocked(const ClockRef& ref) {
+    PageTableEntry* entry = ref.page.pageTableIndex < pageTables.size()
+        ? pageTables[ref.page.pageTableIndex].getEntry(ref.page.pageNo) : nullptr;
+    return entry && entry->present && entry->clockTag == ref.tag ? entry : nullptr;
+}
+
+/**
+ * CLOCK(二次机会)置换(需已持有 mtx):
+ *  - 队首页访问位为1: 清0后放回队尾
+ *  - 访问位为0: 内容写入交换区,腾出其帧
+ *  - 过期项(页已被释放或已重新入队)直接丢弃
+ */
+bool MemoryManager::evictFromLocked(ResidentSet& rs, size_t& frameNumber) {
+    while (!rs.clock.empty()) {
+        ClockRef ref = rs.clock.front();
+        rs.clock.pop_front();
+
+        PageTableEntry* entry = clockEntryLocked(ref);
+        if (!entry) {
+            continue;
+        }
+        // 快速路径的访问标记同样给予第二次机会
+        bool hot = frameHot[entry->frameNumber].exchange(0, memory_order_relaxed) != 0;
+        if (entry->referenced || hot) {
+            entry->referenced = false;
+            rs.clock.push_back(ref);
+            continue;
+        }
+
+        beginRemapLocked();
+        auto frameBegin = physicalMemory.begin() + entry->frameNumber * pageSize;
+        swapStore[{ ref.page.pageTableIndex, ref.page.pageNo }].assign(frameBegin, frameBegin + pageSize);
+        entry->present = false;
+        entry->swapped = true;
+        frameNumber = entry->frameNumber;
+        frameOwner[frameNumber].pageTableIndex = static_cast<size_t>(-1);
+
+        rs.resident--;
+        rs.evictions++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * 释放一页(需已持有 mtx): 帧退休后再回到 freeFrames,交换区内容丢弃
+ */
+void MemoryManager::releasePageLocked(const SegmentDescriptor& seg, PageTableEntry* entry, size_t pageNo) {
+    if (entry->present) {
+        frameOwner[entry->frameNumber].pageTableIndex = static_cast<size_t>(-1);
+        retireFrameLocked(entry->frameNumber);
+        entry->present = false;
+        if (seg.owner >= 0) {
+            residentSets[seg.owner].resident--;
+        }
+    }
+    if (entry->swapped) {
+        swapStore.erase({ seg.pageTableIndex, pageNo });
+        entry->swapped = false;
+    }
+}
+
+/**
+ * 使用全局段号 + 段内偏移 做地址转换
+ * (内部工具函数,对外 translateGlobal 提供封装)
+ */
+bool MemoryManager::translateGlobal(size_t globalSegNo, uint32_t offset, size_t& physicalAddress) const {
+    lock_guard<mutex> lock(mtx);
+
+    const SegmentDescriptor* seg;
+    size_t pageOffset;
+    const PageTableEntry* entry = lookupEntryLocked(globalSegNo, offset, seg, pageOffset, "translateGlobal");
+    if (!entry) {
+        return false;
+    }
+    if (!entry->present) {
         cerr << "[MemoryManager] translateGlobal: page not present." << endl;
         return false;
     }
@@ -183,39 +664,611 @@ bool MemoryManager::translate(const LogicalAddress& la, size_t& physicalAddress)
 
 /**
  * 全局写一个字节
+ *  - 若所在页尚未分配帧或已被换出,此时缺页处理(按需分配/换入)
  */
 bool MemoryManager::writeByteGlobal(size_t globalSegNo, uint32_t offset, uint8_t value) {
-    size_t pa;
-    if (!translateGlobal(globalSegNo, offset, pa)) {
+    lock_guard<mutex> lock(mtx); // 查表与写物理内存在同一临界区内完成
+
+    const SegmentDescriptor* seg;
+    size_t pageOffset;
+    PageTableEntry* entry = const_cast<PageTableEntry*>(
+        lookupEntryLocked(globalSegNo, offset, seg, pageOffset, "writeByteGlobal"));
+    if (!entry) {
+        return false;
+    }
+
+    if (!entry->present && !faultInLocked(*seg, entry)) {
+        cerr << "[MemoryManager] writeByteGlobal: no free frame for page fault." << endl;
         return false;
     }
-    lock_guard<mutex> lock(mtx); // 写物理内存时加锁
-    physicalMemory[pa] = value;
+    noteAccessLocked(*seg, entry);
+
+    physicalMemory[entry->frameNumber * pageSize + pageOffset] = value;
     return true;
 }
 
 /**
  * 全局读一个字节
+ *  - 尚未分配帧的页视为全0页,不分配帧
+ *  - 已被换出的页先换入再读
  */
-bool MemoryManager::readByteGlobal(size_t globalSegNo, uint32_t offset, uint8_t& value) const {
-    size_t pa;
-    if (!translateGlobal(globalSegNo, offset, pa)) {
+bool MemoryManager::readByteGlobal(size_t globalSegNo, uint32_t offset, uint8_t& value) {
+    lock_guard<mutex> lock(mtx); // 与写操作互斥
+
+    const SegmentDescriptor* seg;
+    size_t pageOffset;
+    PageTableEntry* entry = const_cast<PageTableEntry*>(
+        lookupEntryLocked(globalSegNo, offset, seg, pageOffset, "readByteGlobal"));
+    if (!entry) {
         return false;
     }
-    lock_guard<mutex> lock(mtx); // 读物理内存时同样加锁,确保与写操作互斥
-    value = physicalMemory[pa];
+
+    if (entry->swapped && !faultInLocked(*seg, entry)) {
+        cerr << "[MemoryManager] readByteGlobal: no free frame for swap-in." << endl;
+        return false;
+    }
+    noteAccessLocked(*seg, entry);
+
+    value = entry->present ? physicalMemory[entry->frameNumber * pageSize + pageOffset] : 0;
     return true;
 }
 
 /**
- * 段表访问接口
+ * 批量接口的公共流程(需已持有 mtx):
+ *  - 每 kBatchChunk 个地址为一块
+ *  - 第一遍: 查段表(与上一个地址同段则复用),算出页表项地址并预取
+ *  - 第二遍: 读取页表项,交给 visit 处理
  */
-SegmentDescriptor* MemoryManager::getSegmentDescriptor(size_t globalSegNo) {
+template <class Geometry, class Visit>
+size_t MemoryManager::batchLocked(const Geometry& geo, const LogicalAddress* las, size_t count,
+    TranslateStatus* status, Visit&& visit) const {
+    const size_t kBatchChunk = 16;
+    const SegmentDescriptor* segs[kBatchChunk];
+    const PageTableEntry* entries[kBatchChunk];
+    size_t pageOffsets[kBatchChunk];
+
+    size_t cachedSegNo = static_cast<size_t>(-1);
+    const SegmentDescriptor* segDesc = nullptr;
+    const PageTable* pt = nullptr;
+    size_t succeeded = 0;
+
+    for (size_t base = 0; base < count; base += kBatchChunk) {
+        size_t n = min(kBatchChunk, count - base);
+
+        for (size_t j = 0; j < n; ++j) {
+            const LogicalAddress& la = las[base + j];
+            if (la.segment != cachedSegNo) {
+                cachedSegNo = la.segment;
+                pt = findPageTableLocked(la.segment, segDesc);
+            }
+
+            segs[j] = segDesc;
+            entries[j] = nullptr;
+            if (!pt) {
+                status[base + j] = TranslateStatus::InvalidSegment;
+                continue;
+            }
+            status[base + j] = lookupEntryImpl(geo, *segDesc, *pt, la.offset, entries[j], pageOffsets[j]);
+            if (status[base + j] == TranslateStatus::Ok) {
+                prefetchRead(entries[j]);
+            }
+        }
+
+        for (size_t j = 0; j < n; ++j) {
+            if (status[base + j] != TranslateStatus::Ok) {
+                continue;
+            }
+            status[base + j] = visit(base + j, *segs[j], *entries[j], pageOffsets[j]);
+            if (status[base + j] == TranslateStatus::Ok) {
+                ++succeeded;
+            }
+        }
+    }
+    return succeeded;
+}
+
+/**
+ * 批量地址转换
+ */
+size_t MemoryManager::translateBatch(const LogicalAddress* las, size_t count,
+    size_t* physicalAddresses, TranslateStatus* status) const {
+    lock_guard<mutex> lock(mtx);
+    return withGeometry([&](const auto& geo) {
+        return batchLocked(geo, las, count, status,
+            [&](size_t i, const SegmentDescriptor&, const PageTableEntry& entry, size_t pageOffset) {
+                if (!entry.present) {
+                    return TranslateStatus::NotPresent;
+                }
+                physicalAddresses[i] = entry.frameNumber * pageSize + pageOffset;
+                return TranslateStatus::Ok;
+            });
+        });
+}
+
+/**
+ * 批量读(gather)
+ */
+size_t MemoryManager::readBytesBatch(const LogicalAddress* las, size_t count,
+    uint8_t* values, TranslateStatus* status) {
+    lock_guard<mutex> lock(mtx);
+    return withGeometry([&](const auto& geo) {
+        return batchLocked(geo, las, count, status,
+            [&](size_t i, const SegmentDescriptor& seg, const PageTableEntry& entry, size_t pageOffset) {
+                // 页表项属于本对象,在非 const 方法中修改是安全的
+                PageTableEntry* e = const_cast<PageTableEntry*>(&entry);
+                if (e->swapped && !faultInLocked(seg, e)) {
+                    return TranslateStatus::NoFreeFrame;
+                }
+                noteAccessLocked(seg, e);
+                values[i] = e->present ? physicalMemory[e->frameNumber * pageSize + pageOffset] : 0;
+                return TranslateStatus::Ok;
+            });
+        });
+}
+
+/**
+ * 批量写(scatter)
+ */
+size_t MemoryManager::writeBytesBatch(const LogicalAddress* las, size_t count,
+    const uint8_t* values, TranslateStatus* status) {
     lock_guard<mutex> lock(mtx);
-    return segmentTable.getSegment(globalSegNo);
+    return withGeometry([&](const auto& geo) {
+        return batchLocked(geo, las, count, status,
+            [&](size_t i, const SegmentDescriptor& seg, const PageTableEntry& entry, size_t pageOffset) {
+                // 页表项属于本对象,在非 const 方法中修改是安全的
+                PageTableEntry* e = const_cast<PageTableEntry*>(&entry);
+                if (!e->present && !faultInLocked(seg, e)) {
+                    return TranslateStatus::NoFreeFrame;
+                }
+                noteAccessLocked(seg, e);
+                physicalMemory[e->frameNumber * pageSize + pageOffset] = values[i];
+                return TranslateStatus::Ok;
+            });
+        });
 }
 
-const SegmentDescriptor* MemoryManager::getSegmentDescriptor(size_t globalSegNo) const {
+/**
+ * 增量式物理帧整理:
+ *  - 目标帧 = 最低编号的空闲帧,源帧 = 最高编号的在用帧,由空闲帧树 O(log n) 给出
+ *  - 源帧所属页表项由常驻的反向映射 frameOwner 给出,不扫描页表
+ *  - 每搬一帧前检查 pauseBudget,超时即停止,剩余部分留给下一次调用
+ */
+FrameCompactionStats MemoryManager::compactFrames(chrono::microseconds pauseBudget) {
     lock_guard<mutex> lock(mtx);
-    return segmentTable.getSegment(globalSegNo);
+    auto deadline = chrono::steady_clock::now() + pauseBudget;
+
+    // 先等无锁读者退出: 之后既可以安全搬移帧,退休帧也都回到了空闲帧树
+    bool move = pauseBudget.count() > 0 && (!freeFrames.isCompacted() || !retiredFrames.empty());
+    if (move) {
+        beginRemapLocked();
+    }
+
+    FrameCompactionStats stats;
+    stats.largestFreeRunBefore = freeFrames.largestRun();
+    stats.freeRunsBefore = freeFrames.runs();
+
+    if (move) {
+        size_t to = 0;
+        size_t from = 0;
+        while (!freeFrames.isCompacted() && chrono::steady_clock::now() < deadline
+            && freeFrames.allocate(to)) {
+            freeFrames.lastUsed(from);
+            PageRef ref = frameOwner[from];
+            PageTableEntry* entry = pageTables[ref.pageTableIndex].getEntry(ref.pageNo);
+
+            copy(physicalMemory.begin() + from * pageSize,
+                physicalMemory.begin() + (from + 1) * pageSize,
+                physicalMemory.begin() + to * pageSize);
+            entry->frameNumber = to;
+            frameOwner[to] = ref;
+            frameHot[to].store(frameHot[from].exchange(0, memory_order_relaxed), memory_order_relaxed);
+            frameOwner[from].pageTableIndex = static_cast<size_t>(-1);
+            freeFrames.release(from);
+
+            ++stats.framesMoved;
+            stats.bytesMoved += pageSize;
+        }
+    }
+
+    stats.done = freeFrames.isCompacted() && retiredFrames.empty();
+    stats.largestFreeRunAfter = freeFrames.largestRun();
+    stats.freeRunsAfter = freeFrames.runs();
+    return stats;
+}
+
+/**
+ * 帧映射即将改变(需已持有 mtx):
+ *  - 先推进代号,新的快速路径会发现缓存失效并转入加锁的慢路径
+ *  - 再等待已进入纪元临界区的读者退出,之后才能移动或复用帧
+ *  - 等待结束后所有退休帧也都已安全,一并回收
+ */
+void MemoryManager::beginRemapLocked() {
+    layoutGeneration.fetch_add(1);
+    EpochManager::instance().synchronize();
+    reclaimRetiredLocked(false);
+}
+
+/**
+ * 释放一帧但不等待读者: 帧按当前纪元退休,读者全部退出后由 reclaimRetiredLocked 回收
+ */
+void MemoryManager::retireFrameLocked(size_t frameNumber) {
+    layoutGeneration.fetch_add(1);
+    retiredFrames.push_back({ EpochManager::instance().currentEpoch(), frameNumber });
+}
+
+/**
+ * 回收已安全的退休帧(按退休纪元递增排列,遇到第一个不安全的即可停止)
+ *  - wait=true 时先等待当前读者全部退出,保证所有退休项都能回收
+ */
+void MemoryManager::reclaimRetiredLocked(bool wait) {
+    if (retiredFrames.empty()) {
+        return;
+    }
+    EpochManager& em = EpochManager::instance();
+    if (wait) {
+        em.synchronize();
+    }
+    else {
+        em.tryAdvance();
+    }
+
+    size_t n = 0;
+    while (n < retiredFrames.size() && em.isSafe(retiredFrames[n].first)) {
+        freeFrames.release(retiredFrames[n].second);
+        ++n;
+    }
+    retiredFrames.erase(retiredFrames.begin(), retiredFrames.begin() + n);
+}
+
+/**
+ * 每线程的原子操作地址缓存(类似 TLB,直接映射)
+ * 每项记录某段中一页的合法偏移范围 [lo, hi) 及其物理帧地址
+ */
+struct AtomicTlbEntry {
+    const MemoryManager* mm = nullptr;
+    size_t segNo = 0;
+    size_t lo = 0;
+    size_t hi = 0;
+    size_t pageStart = 0;
+    uint8_t* frame = nullptr;
+    atomic<uint8_t>* hot = nullptr;         // 该帧的快速路径访问标记
+    atomic<size_t>* accesses = nullptr;     // 所属进程的快速路径访问计数,不记账的段为空
+    uint64_t generation = 0;
+};
+
+static const size_t kAtomicTlbEntries = 8;
+static thread_local AtomicTlbEntry atomicTlb[kAtomicTlbEntries];
+
+/**
+ * 原子操作的公共实现:
+ *  - 快速路径: 线程缓存命中且代号未变,在纪元临界区内直接对物理内存做原子操作,
+ *    并置帧的访问标记、累加进程的访问计数(均为 relaxed 原子操作)
+ *  - 慢路径: 加锁查页表(必要时缺页处理),完成操作并填充线程缓存
+ */
+template <class T, class Op>
+bool MemoryManager::atomicAccess(size_t globalSegNo, uint32_t offset, Op&& op, const char* caller) {
+    static_assert(sizeof(atomic<T>) == sizeof(T), "atomic<T> must have the same layout as T");
+
+    if (offset % sizeof(T) != 0) {
+        cerr << "[MemoryManager] " << caller << ": misaligned offset " << offset << endl;
+        return false;
+    }
+
+    size_t pageKey = withGeometry([&](const auto& geo) { return geo.pageNo(offset); });
+    AtomicTlbEntry& tlb = atomicTlb[(globalSegNo * 31 + pageKey) % kAtomicTlbEntries];
+    if (tlb.mm == this && tlb.segNo == globalSegNo && offset >= tlb.lo && offset + sizeof(T) <= tlb.hi) {
+        EpochGuard guard(EpochManager::instance());
+        if (layoutGeneration.load() == tlb.generation) {
+            op(*reinterpret_cast<atomic<T>*>(tlb.frame + (offset - tlb.pageStart)));
+            // 先读后写: 标记已置位时不再写,避免多线程反复写同一缓存行
+            if (!tlb.hot->load(memory_order_relaxed)) {
+                tlb.hot->store(1, memory_order_relaxed);
+            }
+            if (tlb.accesses) {
+                tlb.accesses->fetch_add(1, memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+
+    lock_guard<mutex> lock(mtx);
+
+    const SegmentDescriptor* seg;
+    size_t pageOffset;
+    PageTableEntry* entry = const_cast<PageTableEntry*>(
+        lookupEntryLocked(globalSegNo, offset, seg, pageOffset, caller));
+    if (!entry) {
+        return false;
+    }
+    size_t segLo = seg->growsDown ? seg->top - seg->limit : 0;
+    size_t segHi = seg->growsDown ? seg->top : seg->limit;
+    if (pageOffset + sizeof(T) > pageSize || offset + sizeof(T) > segHi) {
+        cerr << "[MemoryManager] " << caller << ": operand crosses page or segment end." << endl;
+        return false;
+    }
+    if (!entry->present && !faultInLocked(*seg, entry)) {
+        cerr << "[MemoryManager] " << caller << ": no free frame for page fault." << endl;
+        return false;
+    }
+    noteAccessLocked(*seg, entry);
+
+    uint8_t* frame = physicalMemory.data() + entry->frameNumber * pageSize;
+    if (reinterpret_cast<uintptr_t>(frame + pageOffset) % sizeof(T) != 0) {
+        cerr << "[MemoryManager] " << caller << ": page size does not allow aligned access." << endl;
+        return false;
+    }
+    op(*reinterpret_cast<atomic<T>*>(frame + pageOffset));
+
+    size_t pageStart = offset - pageOffset;
+    tlb.mm = this;
+    tlb.segNo = globalSegNo;
+    tlb.lo = max(pageStart, segLo);
+    tlb.hi = min(pageStart + pageSize, segHi);
+    tlb.pageStart = pageStart;
+    tlb.frame = frame;
+    tlb.hot = &frameHot[entry->frameNumber];
+    tlb.accesses = seg->owner >= 0 ? &residentSets[seg->owner].fastAccesses : nullptr;
+    tlb.generation = layoutGeneration.load();
+    return true;
+}
+
+bool MemoryManager::atomicCompareExchange(size_t globalSegNo, uint32_t offset,
+    uint32_t& expected, uint32_t desired, bool& exchanged) {
+    return atomicAccess<uint32_t>(globalSegNo, offset, [&](atomic<uint32_t>& a) {
+        exchanged = a.compare_exchange_strong(expected, desired);
+        }, "atomicCompareExchange");
+}
+
+bool MemoryManager::atomicCompareExchange(size_t globalSegNo, uint32_t offset,
+    uint64_t& expected, uint64_t desired, bool& exchanged) {
+    return atomicAccess<uint64_t>(globalSegNo, offset, [&](atomic<uint64_t>& a) {
+        exchanged = a.compare_exchange_strong(expected, desired);
+        }, "atomicCompareExchange");
+}
+
+bool MemoryManager::atomicFetchAdd(size_t globalSegNo, uint32_t offset, uint32_t delta, uint32_t& previous) {
+    return atomicAccess<uint32_t>(globalSegNo, offset, [&](atomic<uint32_t>& a) {
+        previous = a.fetch_add(delta);
+        }, "atomicFetchAdd");
+}
+
+bool MemoryManager::atomicFetchAdd(size_t globalSegNo, uint32_t offset, uint64_t delta, uint64_t& previous) {
+    return atomicAccess<uint64_t>(globalSegNo, offset, [&](atomic<uint64_t>& a) {
+        previous = a.fetch_add(delta);
+        }, "atomicFetchAdd");
+}
+
+bool MemoryManager::atomicExchange(size_t globalSegNo, uint32_t offset, uint32_t value, uint32_t& previous) {
+    return atomicAccess<uint32_t>(globalSegNo, offset, [&](atomic<uint32_t>& a) {
+        previous = a.exchange(value);
+        }, "atomicExchange");
+}
+
+bool MemoryManager::atomicExchange(size_t globalSegNo, uint32_t offset, uint64_t value, uint64_t& previous) {
+    return atomicAccess<uint64_t>(globalSegNo, offset, [&](atomic<uint64_t>& a) {
+        previous = a.exchange(value);
+        }, "atomicExchange");
+}
+
+bool MemoryManager::atomicLoad(size_t globalSegNo, uint32_t offset, uint32_t& value) {
+    return atomicAccess<uint32_t>(globalSegNo, offset, [&](atomic<uint32_t>& a) {
+        value = a.load();
+        }, "atomicLoad");
+}
+
+bool MemoryManager::atomicLoad(size_t globalSegNo, uint32_t offset, uint64_t& value) {
+    return atomicAccess<uint64_t>(globalSegNo, offset, [&](atomic<uint64_t>& a) {
+        value = a.load();
+        }, "atomicLoad");
+}
+
+bool MemoryManager::atomicStore(size_t globalSegNo, uint32_t offset, uint32_t value) {
+    return atomicAccess<uint32_t>(globalSegNo, offset, [&](atomic<uint32_t>& a) {
+        a.store(value);
+        }, "atomicStore");
+}
+
+bool MemoryManager::atomicStore(size_t globalSegNo, uint32_t offset, uint64_t value) {
+    return atomicAccess<uint64_t>(globalSegNo, offset, [&](atomic<uint64_t>& a) {
+        a.store(value);
+        }, "atomicStore");
+}
+
+/**
+ * 定位块复制中某一字节的主机地址(需已持有 mtx)
+ *  - 写入时对不在内存的页做缺页处理
+ *  - 读取时只换入被换出的页,从未写过的页视为全0
+ */
+bool MemoryManager::resolveBlockLocked(size_t segNo, uint32_t offset, bool forWrite,
+    const PageTableEntry*& entryOut, uint8_t*& host, size_t& avail, const char* caller) {
+    const SegmentDescriptor* seg;
+    size_t pageOffset;
+    PageTableEntry* entry = const_cast<PageTableEntry*>(
+        lookupEntryLocked(segNo, offset, seg, pageOffset, caller));
+    if (!entry) {
+        return false;
+    }
+
+    bool needFault = forWrite ? !entry->present : entry->swapped;
+    if (needFault && !faultInLocked(*seg, entry)) {
+        cerr << "[MemoryManager] " << caller << ": no free frame for page fault." << endl;
+        return false;
+    }
+    noteAccessLocked(*seg, entry);
+
+    size_t segHi = seg->growsDown ? seg->top : seg->limit;
+    avail = min(pageSize - pageOffset, segHi - offset);
+    host = entry->present ? physicalMemory.data() + entry->frameNumber * pageSize + pageOffset : nullptr;
+    entryOut = entry;
+    return true;
+}
+
+/**
+ * 复制块中从 at 起的一段(需已持有 mtx),最多 want 字节,实际复制的字节数由 chunk 返回:
+ *  - 取源、目标两侧在当前页内剩余字节数的较小者,直接 memmove
+ *  - 先解析源页再解析目标页;目标页缺页时可能换出刚解析的源页,此时重新解析
+ */
+bool MemoryManager::copyChunkLocked(const BlockRef* src, const uint8_t* srcHost,
+    const BlockRef* dst, uint8_t* dstHost, size_t at, size_t want, size_t& chunk, const char* caller) {
+    uint8_t* from = const_cast<uint8_t*>(srcHost ? srcHost + at : nullptr);
+    uint8_t* to = dstHost ? dstHost + at : nullptr;
+    chunk = want;
+
+    for (int attempt = 0; ; ++attempt) {
+        const PageTableEntry* srcEntry = nullptr;
+        const PageTableEntry* dstEntry = nullptr;
+        size_t avail;
+        if (src) {
+            if (!resolveBlockLocked(src->segNo, static_cast<uint32_t>(src->offset + at), false,
+                srcEntry, from, avail, caller)) {
+                return false;
+            }
+            chunk = min(chunk, avail);
+        }
+        if (dst) {
+            if (!resolveBlockLocked(dst->segNo, static_cast<uint32_t>(dst->offset + at), true,
+                dstEntry, to, avail, caller)) {
+                return false;
+            }
+            chunk = min(chunk, avail);
+        }
+        if (!src || !from || srcEntry->present) {
+            break;
+        }
+        if (attempt == 2) {
+            cerr << "[MemoryManager] " << caller << ": source and destination keep evicting each other." << endl;
+            return false;
+        }
+    }
+
+    if (from) {
+        memmove(to, from, chunk);
+    }
+    else {
+        memset(to, 0, chunk);
+    }
+    return true;
+}
+
+/**
+ * 块复制的实际实现(需已持有 mtx),语义同 memmove:
+ *  - 一般情况从前往后按页分段复制
+ *  - 同一段内目标区间与源区间重叠且目标在后时,从后往前复制,
+ *    保证每段读取的源字节尚未被前面写入的目标覆盖
+ */
+bool MemoryManager::copyBlockLocked(const BlockRef* src, const uint8_t* srcHost,
+    const BlockRef* dst, uint8_t* dstHost, size_t length, const char* caller) {
+    bool backward = src && dst && src->segNo == dst->segNo
+        && dst->offset > src->offset && dst->offset < src->offset + length;
+
+    if (!backward) {
+        size_t done = 0;
+        while (done < length) {
+            size_t chunk;
+            if (!copyChunkLocked(src, srcHost, dst, dstHost, done, length - done, chunk, caller)) {
+                return false;
+            }
+            done += chunk;
+        }
+        return true;
+    }
+
+    size_t end = length;
+    while (end > 0) {
+        // 以 end 为结尾、且在源、目标各自页内的最长一段
+        size_t last = end - 1;
+        size_t want = withGeometry([&](const auto& geo) {
+            return min(geo.pageOffset(src->offset + last), geo.pageOffset(dst->offset + last)) + 1;
+            });
+        want = min(want, end);
+
+        size_t chunk;
+        if (!copyChunkLocked(src, nullptr, dst, nullptr, end - want, want, chunk, caller)) {
+            return false;
+        }
+        if (chunk != want) {
+            cerr << "[MemoryManager] " << caller << ": block exceeds segment bounds." << endl;
+            return false;
+        }
+        end -= want;
+    }
+    return true;
+}
+
+/**
+ * 批量块复制(帧到帧)
+ */
+size_t MemoryManager::copyBlocksGlobal(const BlockRef* src, const BlockRef* dst, size_t count) {
+    lock_guard<mutex> lock(mtx);
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = min(src[i].length, dst[i].length);
+        if (!copyBlockLocked(&src[i], nullptr, &dst[i], nullptr, length, "copyBlocksGlobal")) {
+            return i;
+        }
+    }
+    return count;
+}
+
+/**
+ * 主机缓冲区 -> 段
+ */
+bool MemoryManager::writeBlockGlobal(const BlockRef& dst, const uint8_t* data) {
+    lock_guard<mutex> lock(mtx);
+    return copyBlockLocked(nullptr, data, &dst, nullptr, dst.length, "writeBlockGlobal");
+}
+
+/**
+ * 段 -> 主机缓冲区
+ */
+bool MemoryManager::readBlockGlobal(const BlockRef& src, uint8_t* out) {
+    lock_guard<mutex> lock(mtx);
+    return copyBlockLocked(&src, nullptr, nullptr, out, src.length, "readBlockGlobal");
+}
+
+/**
+ * 设置进程驻留集上限,超出部分立即换出
+ */
+void MemoryManager::setResidentLimit(int ownerId, size_t maxFrames, int reclaimPriority) {
+    lock_guard<mutex> lock(mtx);
+
+    ResidentSet& rs = residentSets[ownerId];
+    rs.limitFrames = maxFrames;
+    rs.reclaimPriority = reclaimPriority;
+
+    size_t frameNumber;
+    while (maxFrames != 0 && rs.resident > maxFrames && evictFromLocked(rs, frameNumber)) {
+        freeFrames.release(frameNumber);
+    }
+}
+
+/**
+ * 查询进程驻留集统计
+ */
+ResidentSetStats MemoryManager::getResidentSetStats(int ownerId) const {
+    lock_guard<mutex> lock(mtx);
+
+    ResidentSetStats stats;
+    auto it = residentSets.find(ownerId);
+    if (it == residentSets.end()) {
+        return stats;
+    }
+    const ResidentSet& rs = it->second;
+    stats.limitFrames = rs.limitFrames;
+    stats.reclaimPriority = rs.reclaimPriority;
+    stats.residentFrames = rs.resident;
+    stats.accesses = rs.accesses + rs.fastAccesses.load(memory_order_relaxed);
+    stats.faults = rs.faults;
+    stats.evictions = rs.evictions;
+    stats.faultRate = stats.accesses ? static_cast<double>(stats.faults) / stats.accesses : 0.0;
+    return stats;
+}
+
+/**
+ * 段表访问接口
+ */
+SegmentDescriptor MemoryManager::getSegmentDescriptor(size_t globalSegNo) const {
+    lock_guard<mutex> lock(mtx);
+
+    const SegmentDescriptor* seg = segmentTable.getSegment(globalSegNo);
+    return seg ? *seg : SegmentDescriptor();
 }
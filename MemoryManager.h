@@ -2,17 +2,72 @@
 #include <cstddef>
 #include <cstdint>
 #include <vector>
+#include <memory>
+#include <deque>
+#include <map>
+#include <unordered_map>
 #include <mutex>        // 线程安全
+#include <atomic>
+#include <chrono>
 #include "Segment.h"
 #include "Page.h"
+#include "PageGeometry.h"
+#include "Epoch.h"
+#include "FreeFrameTree.h"
 
 using namespace std;
 
 struct LogicalAddress {
-    uint16_t segment;   // 全局段号
+    uint32_t segment;   // 全局段号
     uint32_t offset;    // 段内偏移
 };
 
+/**
+ * 单个地址的转换结果(批量接口逐项返回)
+ */
+enum class TranslateStatus {
+    Ok,
+    InvalidSegment,     // 段号无效或段已销毁
+    OutOfRange,         // 偏移超出段界限
+    NotPresent,         // 页尚未分配物理帧
+    NoFreeFrame         // 写入时按需分配帧失败
+};
+
+/**
+ * 段内一段连续字节: 全局段号 + 起始偏移 + 长度
+ */
+struct BlockRef {
+    size_t segNo;
+    uint32_t offset;
+    uint32_t length;
+};
+
+/**
+ * 一次物理帧整理(compactFrames)的结果
+ */
+struct FrameCompactionStats {
+    size_t framesMoved = 0;         // 本次搬移的帧数
+    size_t bytesMoved = 0;          // 本次复制的字节数
+    size_t largestFreeRunBefore = 0;// 整理前最长连续空闲帧数
+    size_t largestFreeRunAfter = 0; // 整理后最长连续空闲帧数
+    size_t freeRunsBefore = 0;      // 整理前空闲帧被切成的段数
+    size_t freeRunsAfter = 0;       // 整理后空闲帧被切成的段数
+    bool done = false;              // 是否已把所有空闲帧聚到高端
+};
+
+/**
+ * 某个进程的驻留集统计(getResidentSetStats 返回)
+ */
+struct ResidentSetStats {
+    size_t limitFrames = 0;         // 驻留帧上限,0 表示不限制
+    int reclaimPriority = 0;        // 回收优先级,越大越先被全局回收
+    size_t residentFrames = 0;      // 当前驻留帧数
+    size_t accesses = 0;            // 读写访问次数
+    size_t faults = 0;              // 缺页次数(首次写入 + 换入)
+    size_t evictions = 0;           // 被换出的页数
+    double faultRate = 0.0;         // faults / accesses,用于发现抖动
+};
+
 /**
  * MemoryManager
  * 负责:
@@ -21,6 +76,10 @@ struct LogicalAddress {
  *  - 提供创建段、销毁段的接口
  *  - 实现逻辑地址到物理地址的转换
  *  - 为多线程并发访问提供互斥保护
+ *  - 释放的物理帧先按纪元退休,等无锁读者全部退出后才回到空闲帧列表
+ *
+ * 不加锁的只有原子操作的快速路径(线程缓存命中时);字节读写、批量接口、
+ * 块复制以及对段表项的所有修改都在 mtx 下进行。
  */
 class MemoryManager {
 public:
@@ -30,17 +89,62 @@ public:
      * 创建一个段(可指定是否为共享段)
      * @param segmentSizeBytes 段大小(字节)
      * @param shared           是否作为共享段创建
+     * @param ownerId          驻留帧记账的进程ID,-1 表示不记账
+     *                         若该进程设置了驻留上限,段内页改为按需分配
      * @return 全局段号,失败返回 (size_t)-1
      */
-    size_t createSegment(size_t segmentSizeBytes, bool shared = false);
+    size_t createSegment(size_t segmentSizeBytes, bool shared = false, int ownerId = -1);
+
+    /**
+     * 创建一个栈式(向低地址增长)段
+     *  - 段上界 top 固定为 maxSizeBytes 向上取整到页
+     *  - 合法偏移为 [top - limit, top),增长时下界降低,已有数据偏移不变
+     * @return 全局段号,失败返回 (size_t)-1
+     */
+    size_t createStackSegment(size_t initialSizeBytes, size_t maxSizeBytes, bool shared = false, int ownerId = -1);
+
+    /**
+     * 原地调整段大小(类似 brk):
+     *  - 增长: 在页表尾部追加页表项,物理帧在首次写入时才分配
+     *  - 缩小: 从页表尾部截断,回收被截掉页的物理帧
+     *  - 不复制已有数据,栈式段同样适用(尾部即低地址端)
+     */
+    bool resizeSegment(size_t globalSegNo, size_t newSizeBytes);
+
+    /**
+     * 按增量调整段大小(类似 sbrk),读取当前大小与调整在同一临界区内完成
+     *  - 被其他进程挂接(refCount > 1 或 attachCount > 1)的共享段不允许缩小
+     * @param newSizeBytes 成功时返回调整后的大小
+     */
+    bool resizeSegmentBy(size_t globalSegNo, ptrdiff_t deltaBytes, size_t& newSizeBytes);
 
     /**
      * 销毁一个全局段:
      *  - 仅当 refCount == 0 时才真正释放物理帧并标记无效
      *  - 一般由共享内存管理或进程结束时调用
+     *  - 不等待并发读者: 物理帧先退休,读者全部退出后才可再分配
+     *  - 段号不会复用,旧段号之后的访问都按无效段报错;页表存储留给新段复用
      */
     bool destroySegment(size_t globalSegNo);
 
+    /**
+     * 共享段引用计数,在 mtx 下修改,与 destroySegment/resizeSegment 互斥:
+     *  - retainSegment : 有效段的 refCount 加1
+     *  - releaseSegment: refCount 减1,不会销毁段(减到0后由调用者决定是否 destroySegment)
+     * @param refCount 成功时返回修改后的计数
+     * @return 段无效(或 release 时 refCount 已为0)返回 false
+     */
+    bool retainSegment(size_t globalSegNo, size_t& refCount);
+    bool releaseSegment(size_t globalSegNo, size_t& refCount);
+
+    /**
+     * 记录/撤销一次进程映射(Process::attachSegment/detachSegment 调用)
+     *  - 映射数大于1的共享段不允许缩小
+     *  - 段已销毁时 detachSegment 直接忽略
+     */
+    bool attachSegment(size_t globalSegNo);
+    void detachSegment(size_t globalSegNo);
+
     /**
      * 逻辑地址 -> 物理地址
      * 这里的逻辑地址使用全局段号。
@@ -60,30 +164,251 @@ public:
 
     /**
      * 通过全局段号 + 段内偏移 读取一个字节
+     * (读到被换出的页会触发换入,因此不是 const)
+     */
+    bool readByteGlobal(size_t globalSegNo, uint32_t offset, uint8_t& value);
+
+    /**
+     * 批量地址转换(适合哈希表探测等随机访问负载):
+     *  - 整批只加一次锁,相邻地址属于同一段时复用段表查找结果
+     *  - 分块先算出页表项地址并软件预取,再读取页表项
+     *  - status[i] 给出每个地址的结果,单个失败不中断整批,也不打印错误
+     * @return 成功的地址数
+     */
+    size_t translateBatch(const LogicalAddress* las, size_t count,
+        size_t* physicalAddresses, TranslateStatus* status) const;
+
+    /**
+     * 批量读(gather): values[i] = 地址 las[i] 处的字节
+     *  - 尚未分配帧的页读出0,与 readByteGlobal 一致
      */
-    bool readByteGlobal(size_t globalSegNo, uint32_t offset, uint8_t& value) const;
+    size_t readBytesBatch(const LogicalAddress* las, size_t count,
+        uint8_t* values, TranslateStatus* status);
+
+    /**
+     * 批量写(scatter): 把 values[i] 写到地址 las[i]
+     *  - 尚未分配帧的页按需分配,与 writeByteGlobal 一致
+     */
+    size_t writeBytesBatch(const LogicalAddress* las, size_t count,
+        const uint8_t* values, TranslateStatus* status);
+
+    /**
+     * 增量式物理帧整理:
+     *  - 把最高编号的在用帧搬到最低编号的空闲帧,使空闲帧在高端连成一片
+     *  - 每次调用只持锁 pauseBudget 左右,可在负载运行期间反复调用直到 done;
+     *    反向映射和碎片统计是常驻维护的,每搬一帧只需 O(log n) 查找,不扫描页表
+     *  - pauseBudget 为0时只返回统计,不搬移
+     *  - 搬移在锁内完成"复制数据 + 改页表项",其他访问者看到的总是一致状态
+     *  - 空闲帧始终按编号升序分配,减少再次碎片化
+     */
+    FrameCompactionStats compactFrames(chrono::microseconds pauseBudget);
+
+    /**
+     * 段内对齐地址上的原子操作(32/64位),直接作用于物理内存:
+     *  - offset 必须按操作数大小对齐
+     *  - 每个线程缓存最近访问页的映射(类似 TLB),命中时只进入纪元临界区、
+     *    不加全局锁,直接对物理内存做主机原子操作
+     *  - 任何会移动/释放帧的操作都会使缓存失效;移动帧前等待临界区内的读者退出,
+     *    释放的帧则延迟到读者退出后再回收
+     *  - 返回 false 表示地址无效或未对齐;compareExchange 的比较结果由 exchanged 给出,
+     *    失败时 expected 被更新为当前值
+     */
+    bool atomicCompareExchange(size_t globalSegNo, uint32_t offset, uint32_t& expected, uint32_t desired, bool& exchanged);
+    bool atomicCompareExchange(size_t globalSegNo, uint32_t offset, uint64_t& expected, uint64_t desired, bool& exchanged);
+    bool atomicFetchAdd(size_t globalSegNo, uint32_t offset, uint32_t delta, uint32_t& previous);
+    bool atomicFetchAdd(size_t globalSegNo, uint32_t offset, uint64_t delta, uint64_t& previous);
+    bool atomicExchange(size_t globalSegNo, uint32_t offset, uint32_t value, uint32_t& previous);
+    bool atomicExchange(size_t globalSegNo, uint32_t offset, uint64_t value, uint64_t& previous);
+    bool atomicLoad(size_t globalSegNo, uint32_t offset, uint32_t& value);
+    bool atomicLoad(size_t globalSegNo, uint32_t offset, uint64_t& value);
+    bool atomicStore(size_t globalSegNo, uint32_t offset, uint32_t value);
+    bool atomicStore(size_t globalSegNo, uint32_t offset, uint64_t value);
+
+    /**
+     * 批量块复制(帧到帧): 把 src[i] 的内容复制到 dst[i]
+     *  - 整批只加一次锁,按页拆分后直接在物理帧之间复制,不经过中间缓冲区
+     *  - src[i].length 与 dst[i].length 取较小者
+     *  - 语义同 memmove: 同一段内源、目标区间重叠时结果等同于先整体读出再写入
+     *  - 目标页按需分配/换入,未分配帧的源页按全0处理
+     *  - 遇到第一个失败的块即停止(该块可能已部分写入)
+     * @return 完整复制的块数,等于 count 表示全部成功
+     */
+    size_t copyBlocksGlobal(const BlockRef* src, const BlockRef* dst, size_t count);
+
+    /**
+     * 块写入/读取: 在主机缓冲区与段之间按页直接复制
+     */
+    bool writeBlockGlobal(const BlockRef& dst, const uint8_t* data);
+    bool readBlockGlobal(const BlockRef& src, uint8_t* out);
+
+    /**
+     * 设置进程的驻留集上限(类似 memory cgroup):
+     *  - maxFrames 为 0 表示不限制
+     *  - 进程达到上限后再缺页,只在自己的页中按 CLOCK 算法换出(局部置换)
+     *  - 全局空闲帧耗尽时,从 reclaimPriority 最大的进程回收
+     *  - 当前驻留数超过新上限时立即换出多余的页
+     */
+    void setResidentLimit(int ownerId, size_t maxFrames, int reclaimPriority = 0);
+
+    /**
+     * 查询进程的驻留集统计(缺页率等)
+     */
+    ResidentSetStats getResidentSetStats(int ownerId) const;
 
     size_t getPageSize() const { return pageSize; }
     size_t getPhysicalMemorySize() const { return physicalMemory.size(); }
 
     /**
-     * 访问全局段表接口(供共享内存管理使用)
+     * 查询全局段表项
+     *  - 加锁后返回段表项的副本,段号不存在时返回 valid=false 的默认值
+     *  - 修改引用计数/大小请使用 retainSegment/releaseSegment/resizeSegmentBy
      */
-    SegmentDescriptor* getSegmentDescriptor(size_t globalSegNo);
-    const SegmentDescriptor* getSegmentDescriptor(size_t globalSegNo) const;
+    SegmentDescriptor getSegmentDescriptor(size_t globalSegNo) const;
 
 private:
     size_t pageSize;
+    size_t pageShift;             // pageSize 为2的幂时的 log2,否则为0
+    PageSizeClass pageClass;      // 构造时确定,用于分派页几何策略
     size_t frameCount;
     vector<uint8_t> physicalMemory;
-    vector<size_t> freeFrames;
+    FreeFrameTree freeFrames;     // 按编号最低优先分配,同时维护碎片统计
 
     SegmentTable segmentTable;
     vector<PageTable> pageTables;
 
+    // 页的全局标识: (页表下标, 页号)
+    struct PageRef {
+        size_t pageTableIndex;
+        size_t pageNo;
+    };
+
+    // CLOCK 队列项: 页 + 入队序号
+    //  - 页被释放或重新入队后,页表项的 clockTag 不再等于 tag,该项即为过期项
+    struct ClockRef {
+        PageRef page;
+        uint64_t tag;
+    };
+
+    // 每个进程的驻留集: 上限、统计,以及 CLOCK 置换用的驻留页队列
+    struct ResidentSet {
+        size_t limitFrames = 0;
+        int reclaimPriority = 0;
+        size_t resident = 0;
+        size_t accesses = 0;
+        atomic<size_t> fastAccesses{ 0 };   // 原子操作快速路径(不加锁)记录的访问次数
+        size_t faults = 0;
+        size_t evictions = 0;
+        deque<ClockRef> clock;
+    };
+
+    // 帧号 -> 占用该帧的页(反向映射),空闲/退休帧的 pageTableIndex 为 (size_t)-1
+    vector<PageRef> frameOwner;
+
+    // 帧号 -> 快速路径访问标记: 快速路径不持锁,不能改页表项的 referenced,
+    // 改为置此标记,CLOCK 扫描时与 referenced 一并视为访问位
+    unique_ptr<atomic<uint8_t>[]> frameHot;
+
+    unordered_map<int, ResidentSet> residentSets;
+    map<pair<size_t, size_t>, vector<uint8_t>> swapStore;  // 被换出页的内容
+    uint64_t clockSeq = 0;                                  // CLOCK 入队序号
+
     // 互斥锁: 用于保护对物理内存、空闲帧、段表、页表的并发访问
     mutable mutex mtx;
 
+    // 原子操作快速路径使用:
+    //  - layoutGeneration: 帧映射每变化一次(换出/释放/整理)加1,使线程缓存失效
+    atomic<uint64_t> layoutGeneration;
+
+    // 已释放但可能仍有无锁读者在访问的帧: (退休纪元, 帧号)
+    vector<pair<uint64_t, size_t>> retiredFrames;
+
+    // 已销毁段留下的空页表位置,新建段优先复用(段号本身不复用)
+    vector<size_t> freePageTables;
+
     bool allocateFrame(size_t& frameNumber);
     size_t calcNumPages(size_t segmentSizeBytes) const;
+    size_t createSegmentLocked(size_t segmentSizeBytes, bool shared, int ownerId);
+    bool resizeSegmentLocked(size_t globalSegNo, size_t newSizeBytes, const char* caller);
+
+    // 查找偏移所在的页表项(需已持有 mtx),失败时打印 caller 并返回 nullptr
+    const PageTableEntry* lookupEntryLocked(size_t globalSegNo, uint32_t offset,
+        const SegmentDescriptor*& segDesc, size_t& pageOffset, const char* caller) const;
+
+    // 查找有效段及其页表(需已持有 mtx),段无效时返回 nullptr
+    const PageTable* findPageTableLocked(size_t globalSegNo, const SegmentDescriptor*& segDesc) const;
+
+    // 段内偏移 -> 页表项地址(不解引用页表项,不打印错误)
+    template <class Geometry>
+    TranslateStatus lookupEntryImpl(const Geometry& geo, const SegmentDescriptor& segDesc,
+        const PageTable& pt, uint32_t offset, const PageTableEntry*& entry, size_t& pageOffset) const;
+
+    // 批量接口的公共流程: visit(i, seg, entry, pageOffset) 处理已找到页表项的地址
+    template <class Geometry, class Visit>
+    size_t batchLocked(const Geometry& geo, const LogicalAddress* las, size_t count,
+        TranslateStatus* status, Visit&& visit) const;
+
+    // 缺页处理: 为不在内存的页取得一帧,换入或清0,并记入所属进程(需已持有 mtx)
+    bool faultInLocked(const SegmentDescriptor& seg, PageTableEntry* entry);
+
+    // 记录一次访问: 置访问位并累计所属进程的访问次数
+    void noteAccessLocked(const SegmentDescriptor& seg, PageTableEntry* entry);
+
+    // 为 ownerId 取得一帧: 超限时局部置换,全局无空闲帧时按优先级回收
+    bool obtainFrameLocked(int ownerId, size_t& frameNumber);
+
+    // 按 CLOCK 算法从 rs 中换出一页,返回腾出的帧
+    bool evictFromLocked(ResidentSet& rs, size_t& frameNumber);
+
+    // 把刚取得帧的页加入 rs 的 CLOCK 队列
+    void enqueueClockLocked(ResidentSet& rs, size_t pageTableIndex, size_t pageNo, PageTableEntry* entry);
+
+    // CLOCK 队列项是否仍指向驻留页,过期项返回 nullptr
+    PageTableEntry* clockEntryLocked(const ClockRef& ref);
+
+    // 帧映射即将改变: 使原子操作的线程缓存失效,并等待快速路径退出(需已持有 mtx)
+    void beginRemapLocked();
+
+    // 释放一帧: 使线程缓存失效并按当前纪元退休,不等待读者(需已持有 mtx)
+    void retireFrameLocked(size_t frameNumber);
+
+    // 把已安全的退休帧/段表项放回空闲列表,wait=true 时先等待读者退出(需已持有 mtx)
+    void reclaimRetiredLocked(bool wait);
+
+    // 原子操作的公共实现: op 作用于目标地址上的 atomic<T>
+    template <class T, class Op>
+    bool atomicAccess(size_t globalSegNo, uint32_t offset, Op&& op, const char* caller);
+
+    // 定位块复制中某一字节的主机地址(需已持有 mtx):
+    //  - host 为 nullptr 表示未分配帧的全0页(仅读取时)
+    //  - avail 为该页内从此字节起剩余的可用字节数
+    bool resolveBlockLocked(size_t segNo, uint32_t offset, bool forWrite,
+        const PageTableEntry*& entry, uint8_t*& host, size_t& avail, const char* caller);
+
+    // 复制块中从 at 起、不跨页的一段(需已持有 mtx),chunk 返回实际字节数
+    bool copyChunkLocked(const BlockRef* src, const uint8_t* srcHost,
+        const BlockRef* dst, uint8_t* dstHost, size_t at, size_t want, size_t& chunk, const char* caller);
+
+    // 块复制的实际实现(需已持有 mtx),srcHost/dstHost 非空时表示主机缓冲区一侧
+    bool copyBlockLocked(const BlockRef* src, const uint8_t* srcHost,
+        const BlockRef* dst, uint8_t* dstHost, size_t length, const char* caller);
+
+    // 释放一页占用的帧和交换区内容(段缩小/销毁时调用)
+    void releasePageLocked(const SegmentDescriptor& seg, PageTableEntry* entry, size_t pageNo);
+
+    /**
+     * 按 pageClass 把 fn 分派到对应的页几何策略实例:
+     *  - 常见页大小(1K/4K/64K/2M)使用编译期常量移位/掩码
+     *  - 其余情况使用运行期移位或除法
+     */
+    template <class Fn>
+    auto withGeometry(Fn&& fn) const -> decltype(fn(DivPageGeometry{ 0 })) {
+        switch (pageClass) {
+        case PageSizeClass::Page1K:     return fn(FixedPageGeometry<1024>());
+        case PageSizeClass::Page4K:     return fn(FixedPageGeometry<4096>());
+        case PageSizeClass::Page64K:    return fn(FixedPageGeometry<65536>());
+        case PageSizeClass::Page2M:     return fn(FixedPageGeometry<2097152>());
+        case PageSizeClass::PowerOfTwo: return fn(ShiftPageGeometry{ pageShift, pageSize - 1 });
+        default:                        return fn(DivPageGeometry{ pageSize });
+        }
+    }
 };
@@ -0,0 +1,327 @@
+#include "MessageQueue.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+static const uint32_t kEnqueuePosOffset = 0;
+static const uint32_t kDequeuePosOffset = 64;
+static const uint32_t kStateOffset = 128;
+static const uint32_t kKindOffset = 132;
+static const uint32_t kCapacityOffset = 136;
+static const uint32_t kSlotSizeOffset = 140;
+static const uint32_t kSlotsOffset = 192;
+
+static const uint32_t kSlotSeqOffset = 0;
+static const uint32_t kSlotLengthOffset = 8;
+static const uint32_t kSlotDataOffset = 16;
+
+// 长度字段取此值表示废弃槽: MPMC 生产者占用了槽却没能写入消息,接收方直接跳过
+static const uint32_t kDeadSlot = UINT32_MAX;
+
+static const uint32_t kStateEmpty = 0;
+static const uint32_t kStateInitializing = 1;
+static const uint32_t kStateReady = 2;
+
+/**
+ * 队列名 -> 共享内存 key
+ */
+static int keyForName(const string& name) {
+    return static_cast<int>(hash<string>()("mq:" + name) & 0x7FFFFFFF);
+}
+
+/**
+ * 打开/创建队列:
+ *  - 创建或获取共享段,并映射到进程地址空间
+ *  - 由第一个打开者初始化段头,其余打开者等待并校验参数
+ */
+MessageQueue::MessageQueue(MemoryManager* mm, SharedMemoryManager* shm, Process* proc, const string& name,
+    QueueKind kind, uint32_t capacity, uint32_t slotSize)
+    : mm(mm), shm(shm), proc(proc), key(keyForName(name)), segNo(static_cast<size_t>(-1)),
+    localSegNo(static_cast<size_t>(-1)), kind(kind), capacity(1), slotSize(slotSize), slotStride(0), open(false) {
+    while (this->capacity < capacity) {
+        this->capacity <<= 1;
+    }
+    // 槽按64字节对齐,避免相邻槽共享缓存行
+    slotStride = (kSlotDataOffset + slotSize + 63) / 64 * 64;
+
+    size_t sizeBytes = kSlotsOffset + static_cast<size_t>(this->capacity) * slotStride;
+    segNo = shm->createOrGet(key, sizeBytes);
+    if (segNo == static_cast<size_t>(-1)) {
+        cerr << "[MessageQueue] Failed to open queue " << name << endl;
+        return;
+    }
+    localSegNo = proc->attachSegment(segNo);
+
+    open = initOrVerify();
+    if (!open) {
+        cerr << "[MessageQueue] Queue " << name << " exists with different parameters." << endl;
+    }
+}
+
+MessageQueue::~MessageQueue() {
+    if (localSegNo != static_cast<size_t>(-1)) {
+        proc->detachSegment(localSegNo);
+    }
+    if (segNo != static_cast<size_t>(-1)) {
+        shm->detach(key);
+    }
+}
+
+/**
+ * 初始化段头(仅一个打开者成功),或等待初始化完成后校验参数
+ */
+bool MessageQueue::initOrVerify() {
+    uint32_t state = kStateEmpty;
+    bool exchanged = false;
+    if (!mm->atomicCompareExchange(segNo, kStateOffset, state, kStateInitializing, exchanged)) {
+        return false;
+    }
+
+    if (exchanged) {
+        mm->atomicStore(segNo, kEnqueuePosOffset, static_cast<uint64_t>(0));
+        mm->atomicStore(segNo, kDequeuePosOffset, static_cast<uint64_t>(0));
+        mm->atomicStore(segNo, kKindOffset, static_cast<uint32_t>(kind));
+        mm->atomicStore(segNo, kCapacityOffset, capacity);
+        mm->atomicStore(segNo, kSlotSizeOffset, slotSize);
+        for (uint32_t i = 0; i < capacity; ++i) {
+            mm->atomicStore(segNo, slotOffset(i) + kSlotSeqOffset, static_cast<uint64_t>(i));
+        }
+        mm->atomicStore(segNo, kStateOffset, kStateReady);
+        return true;
+    }
+
+    while (state != kStateReady) {
+        this_thread::yield();
+        mm->atomicLoad(segNo, kStateOffset, state);
+    }
+    uint32_t k, cap, size;
+    mm->atomicLoad(segNo, kKindOffset, k);
+    mm->atomicLoad(segNo, kCapacityOffset, cap);
+    mm->atomicLoad(segNo, kSlotSizeOffset, size);
+    return k == static_cast<uint32_t>(kind) && cap == capacity && size == slotSize;
+}
+
+uint32_t MessageQueue::slotOffset(uint64_t pos) const {
+    return kSlotsOffset + static_cast<uint32_t>(pos & (capacity - 1)) * slotStride;
+}
+
+/**
+ * 占用槽位:
+ *  - SPSC: 本端位置只有自己修改,只需读取对端位置计算可用数
+ *  - MPMC: 从当前位置起统计序号就绪的连续槽,再用 CAS 一次性推进位置
+ *    (生产者要求 seq == pos,消费者要求 seq == pos + 1)
+ */
+size_t MessageQueue::claim(bool producer, size_t want, uint64_t& pos) {
+    uint32_t ownOffset = producer ? kEnqueuePosOffset : kDequeuePosOffset;
+    uint32_t peerOffset = producer ? kDequeuePosOffset : kEnqueuePosOffset;
+
+    if (kind == QueueKind::SPSC) {
+        uint64_t peer;
+        mm->atomicLoad(segNo, ownOffset, pos);
+        mm->atomicLoad(segNo, peerOffset, peer);
+        size_t avail = producer ? capacity - static_cast<size_t>(pos - peer) : static_cast<size_t>(peer - pos);
+        return min(want, avail);
+    }
+
+    mm->atomicLoad(segNo, ownOffset, pos);
+    while (true) {
+        size_t n = 0;
+        uint64_t seq = 0;
+        while (n < want && n < capacity) {
+            mm->atomicLoad(segNo, slotOffset(pos + n) + kSlotSeqOffset, seq);
+            if (seq != pos + n + (producer ? 0 : 1)) {
+                break;
+            }
+            ++n;
+        }
+
+        if (n == 0) {
+            // 序号落后: 队列满(生产者)或空(消费者);序号超前: 位置已被别人推进
+            if (static_cast<int64_t>(seq - (pos + (producer ? 0 : 1))) < 0) {
+                return 0;
+            }
+            mm->atomicLoad(segNo, ownOffset, pos);
+            continue;
+        }
+
+        bool exchanged = false;
+        mm->atomicCompareExchange(segNo, ownOffset, pos, pos + n, exchanged);
+        if (exchanged) {
+            return n;
+        }
+    }
+}
+
+/**
+ * 发布槽位:
+ *  - SPSC: 推进本端位置
+ *  - MPMC: 逐槽写序号(生产者 pos+1,消费者 pos+capacity)
+ */
+void MessageQueue::publish(bool producer, uint64_t pos, size_t n) {
+    if (kind == QueueKind::SPSC) {
+        mm->atomicStore(segNo, producer ? kEnqueuePosOffset : kDequeuePosOffset, pos + n);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t seq = producer ? pos + i + 1 : pos + i + capacity;
+        mm->atomicStore(segNo, slotOffset(pos + i) + kSlotSeqOffset, seq);
+    }
+}
+
+/**
+ * 放弃已占用的生产者槽位 [pos, pos + n):
+ *  - SPSC: 不推进入队位置即可,槽位留给下次发送
+ *  - MPMC: 槽位可能已被其他生产者越过,只能标记为废弃槽发布出去
+ */
+void MessageQueue::abandon(uint64_t pos, size_t n) {
+    if (kind == QueueKind::SPSC) {
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        mm->atomicStore(segNo, slotOffset(pos + i) + kSlotLengthOffset, kDeadSlot);
+    }
+    publish(true, pos, n);
+}
+
+/**
+ * 批量发送: 发送方段 -> 队列槽,帧到帧复制
+ *  - 复制在第 k 条失败时只发布前 k 条,其余槽位放弃,返回 k
+ */
+size_t MessageQueue::sendBatch(const QueueMessage* msgs, size_t count) {
+    if (!open) {
+        return 0;
+    }
+    size_t want = 0;
+    while (want < count && msgs[want].length <= slotSize) {
+        ++want;
+    }
+
+    uint64_t pos;
+    size_t n = claim(true, want, pos);
+    if (n == 0) {
+        return 0;
+    }
+
+    vector<BlockRef> src(n);
+    vector<BlockRef> dst(n);
+    for (size_t i = 0; i < n; ++i) {
+        src[i] = { proc->getGlobalSegNo(msgs[i].localSegNo), msgs[i].offset, msgs[i].length };
+        dst[i] = { segNo, slotOffset(pos + i) + kSlotDataOffset, msgs[i].length };
+        mm->atomicStore(segNo, slotOffset(pos + i) + kSlotLengthOffset, msgs[i].length);
+    }
+    size_t copied = mm->copyBlocksGlobal(src.data(), dst.data(), n);
+    if (copied < n) {
+        cerr << "[MessageQueue] sendBatch: payload copy failed, sent " << copied << " of " << n << endl;
+    }
+    publish(true, pos, copied);
+    abandon(pos + copied, n - copied);
+    return copied;
+}
+
+/**
+ * 批量接收: 队列槽 -> 接收方段,帧到帧复制
+ *  - 废弃槽直接跳过,不占用 bufs
+ *  - 复制失败时只返回已复制的条数: SPSC 未复制的消息留在队列中;
+ *    MPMC 的槽位已被占用无法退回,这些消息丢弃并打印错误
+ */
+size_t MessageQueue::receiveBatch(const QueueMessage* bufs, uint32_t* lengths, size_t count) {
+    if (!open) {
+        return 0;
+    }
+
+    uint64_t pos;
+    size_t n = claim(false, count, pos);
+    if (n == 0) {
+        return 0;
+    }
+
+    vector<BlockRef> src;
+    vector<BlockRef> dst;
+    vector<size_t> slotOf;      // 第 m 条有效消息所在的槽序号(相对 pos)
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t length;
+        mm->atomicLoad(segNo, slotOffset(pos + i) + kSlotLengthOffset, length);
+        if (length == kDeadSlot) {
+            continue;
+        }
+        size_t m = src.size();
+        length = min(length, bufs[m].length);
+        src.push_back({ segNo, slotOffset(pos + i) + kSlotDataOffset, length });
+        dst.push_back({ proc->getGlobalSegNo(bufs[m].localSegNo), bufs[m].offset, length });
+        slotOf.push_back(i);
+        lengths[m] = length;
+    }
+
+    size_t copied = mm->copyBlocksGlobal(src.data(), dst.data(), src.size());
+    if (copied == src.size()) {
+        publish(false, pos, n);
+        return copied;
+    }
+
+    if (kind == QueueKind::SPSC) {
+        cerr << "[MessageQueue] receiveBatch: payload copy failed, received " << copied << " of " << src.size() << endl;
+        publish(false, pos, slotOf[copied]);
+    }
+    else {
+        cerr << "[MessageQueue] receiveBatch: payload copy failed, dropped " << src.size() - copied << " messages" << endl;
+        publish(false, pos, n);
+    }
+    return copied;
+}
+
+/**
+ * 单条发送(主机缓冲区 -> 队列槽)
+ */
+bool MessageQueue::send(const uint8_t* data, uint32_t length) {
+    if (!open || length > slotSize) {
+        return false;
+    }
+
+    uint64_t pos;
+    if (claim(true, 1, pos) == 0) {
+        return false;
+    }
+    mm->atomicStore(segNo, slotOffset(pos) + kSlotLengthOffset, length);
+    if (!mm->writeBlockGlobal({ segNo, slotOffset(pos) + kSlotDataOffset, length }, data)) {
+        cerr << "[MessageQueue] send: payload copy failed." << endl;
+        abandon(pos, 1);
+        return false;
+    }
+    publish(true, pos, 1);
+    return true;
+}
+
+/**
+ * 单条接收(队列槽 -> 主机缓冲区),跳过废弃槽
+ */
+bool MessageQueue::receive(uint8_t* out, uint32_t outCapacity, uint32_t& length) {
+    if (!open) {
+        return false;
+    }
+
+    while (true) {
+        uint64_t pos;
+        if (claim(false, 1, pos) == 0) {
+            return false;
+        }
+        mm->atomicLoad(segNo, slotOffset(pos) + kSlotLengthOffset, length);
+        if (length == kDeadSlot) {
+            publish(false, pos, 1);
+            continue;
+        }
+
+        length = min(length, outCapacity);
+        if (!mm->readBlockGlobal({ segNo, slotOffset(pos) + kSlotDataOffset, length }, out)) {
+            cerr << "[MessageQueue] receive: payload copy failed." << endl;
+            if (kind == QueueKind::MPMC) {
+                publish(false, pos, 1);
+            }
+            return false;
+        }
+        publish(false, pos, 1);
+        return true;
+    }
+}
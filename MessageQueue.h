@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "MemoryManager.h"
+#include "Process.h"
+#include "SharedMemory.h"
+
+using namespace std;
+
+/**
+ * 消息队列类型
+ *  - SPSC: 单生产者单消费者,只用读写位置两个计数器
+ *  - MPMC: 多生产者多消费者,每个槽带序号(Vyukov 有界队列)
+ */
+enum class QueueKind : uint32_t {
+    SPSC = 1,
+    MPMC = 2
+};
+
+/**
+ * 进程地址空间中的一条消息缓冲区: 本地段号 + 段内偏移 + 长度
+ */
+struct QueueMessage {
+    size_t localSegNo;
+    uint32_t offset;
+    uint32_t length;
+};
+
+/**
+ * MessageQueue 类
+ * 建立在共享段上的进程间环形消息队列:
+ *  - 同名队列通过 SharedMemoryManager::createOrGet 映射到同一个共享段
+ *  - 读写位置与槽序号用 MemoryManager 的原子操作维护,不加全局锁
+ *  - 消息内容通过 copyBlocksGlobal 在发送方段、队列槽、接收方段的物理帧之间直接复制,
+ *    一批消息只加一次锁,不经过中间缓冲区
+ *
+ * 共享段布局:
+ *  [0]   入队位置(64位)       [64]  出队位置(64位)
+ *  [128] 初始化状态/类型/容量/槽大小
+ *  [192] 槽数组,每槽: 序号(64位) + 长度(32位) + 填充 + 数据
+ */
+class MessageQueue {
+public:
+    /**
+     * 以进程 proc 的身份打开(不存在则创建)名为 name 的队列
+     *  - capacity 向上取整为2的幂
+     *  - 已存在的队列其类型/容量/槽大小必须一致,否则打开失败
+     */
+    MessageQueue(MemoryManager* mm, SharedMemoryManager* shm, Process* proc, const string& name,
+        QueueKind kind, uint32_t capacity, uint32_t slotSize);
+
+    /**
+     * 撤销 proc 对队列段的映射并释放共享内存引用
+     */
+    ~MessageQueue();
+
+    // 析构时释放引用,拷贝会导致重复释放
+    MessageQueue(const MessageQueue&) = delete;
+    MessageQueue& operator=(const MessageQueue&) = delete;
+
+    bool isOpen() const { return open; }
+    uint32_t getCapacity() const { return capacity; }
+    uint32_t getSlotSize() const { return slotSize; }
+
+    /**
+     * 批量发送: msgs 位于本进程地址空间
+     *  - 队列满、遇到超过槽大小的消息或复制内容失败时提前停止
+     * @return 实际发送的消息数
+     */
+    size_t sendBatch(const QueueMessage* msgs, size_t count);
+
+    /**
+     * 批量接收: 依次写入 bufs 指定的本进程缓冲区,lengths[i] 为消息实际长度
+     *  - 缓冲区小于消息时截断
+     *  - 复制内容失败时提前停止;MPMC 队列中已取出但未复制的消息会丢弃
+     * @return 实际接收(已复制)的消息数
+     */
+    size_t receiveBatch(const QueueMessage* bufs, uint32_t* lengths, size_t count);
+
+    /**
+     * 单条消息的主机缓冲区版本
+     */
+    bool send(const uint8_t* data, uint32_t length);
+    bool receive(uint8_t* out, uint32_t outCapacity, uint32_t& length);
+
+private:
+    MemoryManager* mm;
+    SharedMemoryManager* shm;
+    Process* proc;
+    int key;
+    size_t segNo;
+    size_t localSegNo;      // 队列段在 proc 中的本地段号
+    QueueKind kind;
+    uint32_t capacity;
+    uint32_t slotSize;
+    uint32_t slotStride;
+    bool open;
+
+    bool initOrVerify();
+    uint32_t slotOffset(uint64_t pos) const;
+
+    // 占用最多 want 个连续槽位,返回实际占用数,pos 为起始位置
+    size_t claim(bool producer, size_t want, uint64_t& pos);
+
+    // 发布已完成的 n 个槽位,使对端可见
+    void publish(bool producer, uint64_t pos, size_t n);
+
+    // 放弃已占用但没能写入消息的 n 个生产者槽位
+    void abandon(uint64_t pos, size_t n);
+};
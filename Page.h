@@ -1,5 +1,6 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 using namespace std;
@@ -9,14 +10,20 @@ using namespace std;
  * ǰ׶ֻҪ:
  * - present: ҳǷڴ
  * - frameNumber: ҳӦ֡
+ * - swapped: ҳ,ݱ MemoryManager Ľ
+ * - referenced: λ, CLOCK û㷨ʹ
+ * - clockTag: һμ CLOCK ʱ,ʶеĹ
  * ׶οڴչȨޡû/ںλȡ
  */
 struct PageTableEntry {
     bool present;       // Ƿڴ
     size_t frameNumber; // Ӧ֡
+    bool swapped;       // Ƿѱ
+    bool referenced;    // Ƿ񱻷ʹ
+    uint64_t clockTag;  // CLOCK 
 
     PageTableEntry()
-        : present(false), frameNumber(0) {
+        : present(false), frameNumber(0), swapped(false), referenced(false), clockTag(0) {
     }
 };
 
@@ -47,6 +54,11 @@ public:
         return &entries[pageNo];
     }
 
+    // ҳ: ʱβ׷Ӳڴеҳ,Сʱβض
+    void resize(size_t numPages) {
+        entries.resize(numPages);
+    }
+
     // ҳ
     size_t size() const {
         return entries.size();
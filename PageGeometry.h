@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+
+using namespace std;
+
+/**
+ * 页几何策略
+ * 负责把段内偏移拆成“页号 + 页内偏移”,以及按页向上取整。
+ * MemoryManager 在构造时根据页大小选定一种策略,热路径按策略实例化:
+ *  - FixedPageGeometry<N>: 编译期页大小(2的幂),全部化为常量移位/掩码
+ *  - ShiftPageGeometry   : 运行期页大小但为2的幂,使用变量移位/掩码
+ *  - DivPageGeometry     : 任意页大小,退化为除法/取模
+ */
+template <size_t PageSizeBytes>
+struct FixedPageGeometry {
+    static_assert(PageSizeBytes != 0 && (PageSizeBytes & (PageSizeBytes - 1)) == 0,
+        "page size must be a power of two");
+
+    static constexpr size_t log2(size_t n) { return n <= 1 ? 0 : 1 + log2(n >> 1); }
+    static constexpr size_t shift = log2(PageSizeBytes);
+    static constexpr size_t mask = PageSizeBytes - 1;
+
+    size_t pageNo(size_t offset) const { return offset >> shift; }
+    size_t pageOffset(size_t offset) const { return offset & mask; }
+    size_t numPages(size_t bytes) const { return (bytes + mask) >> shift; }
+};
+
+struct ShiftPageGeometry {
+    size_t shift;
+    size_t mask;
+
+    size_t pageNo(size_t offset) const { return offset >> shift; }
+    size_t pageOffset(size_t offset) const { return offset & mask; }
+    size_t numPages(size_t bytes) const { return (bytes + mask) >> shift; }
+};
+
+struct DivPageGeometry {
+    size_t pageSize;
+
+    size_t pageNo(size_t offset) const { return offset / pageSize; }
+    size_t pageOffset(size_t offset) const { return offset % pageSize; }
+    size_t numPages(size_t bytes) const { return (bytes + pageSize - 1) / pageSize; }
+};
+
+/**
+ * 构造时选定的页大小类别,用于分派到对应的策略实例
+ */
+enum class PageSizeClass {
+    Page1K,
+    Page4K,
+    Page64K,
+    Page2M,
+    PowerOfTwo,   // 其他2的幂
+    Arbitrary     // 非2的幂
+};
@@ -13,7 +13,7 @@ using namespace std;
  */
 size_t Process::createPrivateSegment(size_t segmentSizeBytes) {
     // ȫڴһ
-    size_t globalSegNo = mm->createSegment(segmentSizeBytes, false);
+    size_t globalSegNo = mm->createSegment(segmentSizeBytes, false, pid);
     if (globalSegNo == static_cast<size_t>(-1)) {
         cerr << "[Process " << pid << "] Failed to create private segment." << endl;
         return static_cast<size_t>(-1);
@@ -21,6 +21,7 @@ size_t Process::createPrivateSegment(size_t segmentSizeBytes) {
 
     lock_guard<mutex> lock(procMtx);
     segmentMap.push_back(globalSegNo);
+    attached.push_back(false);
     size_t localSegNo = segmentMap.size() - 1;
 
     cout << "[Process " << pid << "] Created private segment (localSegNo="
@@ -39,8 +40,14 @@ size_t Process::attachSegment(size_t globalSegNo) {
         return static_cast<size_t>(-1);
     }
 
+    if (!mm->attachSegment(globalSegNo)) {
+        cerr << "[Process " << pid << "] attachSegment: invalid global segment." << endl;
+        return static_cast<size_t>(-1);
+    }
+
     lock_guard<mutex> lock(procMtx);
     segmentMap.push_back(globalSegNo);
+    attached.push_back(true);
     size_t localSegNo = segmentMap.size() - 1;
 
     cout << "[Process " << pid << "] Attached segment (localSegNo="
@@ -48,6 +55,134 @@ size_t Process::attachSegment(size_t globalSegNo) {
     return localSegNo;
 }
 
+/**
+ * һ attachSegment ӳ
+ */
+bool Process::detachSegment(size_t localSegNo) {
+    size_t globalSegNo;
+    {
+        lock_guard<mutex> lock(procMtx);
+        if (localSegNo >= segmentMap.size() || !attached[localSegNo]) {
+            cerr << "[Process " << pid << "] detachSegment: segment not attached." << endl;
+            return false;
+        }
+        globalSegNo = segmentMap[localSegNo];
+        segmentMap[localSegNo] = static_cast<size_t>(-1);
+        attached[localSegNo] = false;
+    }
+
+    mm->detachSegment(globalSegNo);
+    cout << "[Process " << pid << "] Detached segment (localSegNo="
+        << localSegNo << ", globalSegNo=" << globalSegNo << ")" << endl;
+    return true;
+}
+
+Process::~Process() {
+    for (size_t i = 0; i < segmentMap.size(); ++i) {
+        if (attached[i]) {
+            mm->detachSegment(segmentMap[i]);
+        }
+    }
+}
+
+/**
+ * Ϊ̴ջʽ˽ж
+ */
+size_t Process::createStackSegment(size_t initialSizeBytes, size_t maxSizeBytes) {
+    size_t globalSegNo = mm->createStackSegment(initialSizeBytes, maxSizeBytes, false, pid);
+    if (globalSegNo == static_cast<size_t>(-1)) {
+        cerr << "[Process " << pid << "] Failed to create stack segment." << endl;
+        return static_cast<size_t>(-1);
+    }
+
+    lock_guard<mutex> lock(procMtx);
+    segmentMap.push_back(globalSegNo);
+    attached.push_back(false);
+    size_t localSegNo = segmentMap.size() - 1;
+
+    cout << "[Process " << pid << "] Created stack segment (localSegNo="
+        << localSegNo << ", globalSegNo=" << globalSegNo
+        << ", size=" << initialSizeBytes << "/" << maxSizeBytes << " bytes)" << endl;
+
+    return localSegNo;
+}
+
+/**
+ * ضδС
+ */
+bool Process::growSegment(size_t localSegNo, ptrdiff_t deltaBytes) {
+    size_t globalSegNo = getGlobalSegNo(localSegNo);
+    if (globalSegNo == static_cast<size_t>(-1)) {
+        cerr << "[Process " << pid << "] growSegment: invalid localSegNo." << endl;
+        return false;
+    }
+
+    size_t newSize = 0;
+    bool ok = mm->resizeSegmentBy(globalSegNo, deltaBytes, newSize);
+    if (ok) {
+        cout << "[Process " << pid << "] Resized segment (localSegNo=" << localSegNo
+            << ", size=" << newSize << " bytes)" << endl;
+    }
+    return ok;
+}
+
+/**
+ * ԭӲ: ضκ -> ȫֶκ ת MemoryManager
+ */
+bool Process::atomicCompareExchange(size_t localSegNo, uint32_t offset,
+    uint32_t& expected, uint32_t desired, bool& exchanged) {
+    size_t globalSegNo = getGlobalSegNo(localSegNo);
+    return globalSegNo != static_cast<size_t>(-1)
+        && mm->atomicCompareExchange(globalSegNo, offset, expected, desired, exchanged);
+}
+
+bool Process::atomicCompareExchange(size_t localSegNo, uint32_t offset,
+    uint64_t& expected, uint64_t desired, bool& exchanged) {
+    size_t globalSegNo = getGlobalSegNo(localSegNo);
+    return globalSegNo != static_cast<size_t>(-1)
+        && mm->atomicCompareExchange(globalSegNo, offset, expected, desired, exchanged);
+}
+
+bool Process::atomicFetchAdd(size_t localSegNo, uint32_t offset, uint32_t delta, uint32_t& previous) {
+    size_t globalSegNo = getGlobalSegNo(localSegNo);
+    return globalSegNo != static_cast<size_t>(-1)
+        && mm->atomicFetchAdd(globalSegNo, offset, delta, previous);
+}
+
+bool Process::atomicFetchAdd(size_t localSegNo, uint32_t offset, uint64_t delta, uint64_t& previous) {
+    size_t globalSegNo = getGlobalSegNo(localSegNo);
+    return globalSegNo != static_cast<size_t>(-1)
+        && mm->atomicFetchAdd(globalSegNo, offset, delta, previous);
+}
+
+bool Process::atomicExchange(size_t localSegNo, uint32_t offset, uint32_t value, uint32_t& previous) {
+    size_t globalSegNo = getGlobalSegNo(localSegNo);
+    return globalSegNo != static_cast<size_t>(-1)
+        && mm->atomicExchange(globalSegNo, offset, value, previous);
+}
+
+bool Process::atomicExchange(size_t localSegNo, uint32_t offset, uint64_t value, uint64_t& previous) {
+    size_t globalSegNo = getGlobalSegNo(localSegNo);
+    return globalSegNo != static_cast<size_t>(-1)
+        && mm->atomicExchange(globalSegNo, offset, value, previous);
+}
+
+/**
+ * ñפ
+ */
+void Process::setResidentLimit(size_t maxFrames, int reclaimPriority) {
+    mm->setResidentLimit(pid, maxFrames, reclaimPriority);
+    cout << "[Process " << pid << "] Resident limit set (maxFrames=" << maxFrames
+        << ", reclaimPriority=" << reclaimPriority << ")" << endl;
+}
+
+/**
+ * ѯפͳ
+ */
+ResidentSetStats Process::getResidentSetStats() const {
+    return mm->getResidentSetStats(pid);
+}
+
 /**
  * ضκ -> ȫֶκ
  */
@@ -26,6 +26,14 @@ public:
         : pid(pid), mm(mm) {
     }
 
+    /**
+     * δ detach ӳ,ʹ MemoryManager еӳ׼ȷ
+     */
+    ~Process();
+
+    Process(const Process&) = delete;
+    Process& operator=(const Process&) = delete;
+
     int getPid() const { return pid; }
 
     /**
@@ -39,10 +47,55 @@ public:
     /**
      * һѴڵġȫֶΡӳ䵽̵ַռ
      *  - ͨڹ attach
+     *  -  MemoryManager м¼һӳ(ӳ1ĹβС)
      *  - رضκ
      */
     size_t attachSegment(size_t globalSegNo);
 
+    /**
+     *  attachSegment ӳ
+     *  - ضκʧЧ(ӳΪ -1),ᱻ
+     */
+    bool detachSegment(size_t localSegNo);
+
+    /**
+     * Ϊ̴һջʽ˽ж(͵ַ)
+     *  - ϷƫΪ [top - ǰС, top),top  maxSizeBytes 
+     *  - رضκ
+     */
+    size_t createStackSegment(size_t initialSizeBytes, size_t maxSizeBytes);
+
+    /**
+     * ضδС( sbrk):
+     *  - deltaBytes > 0 , < 0 С
+     *  - ڲ MemoryManager::resizeSegmentBy,
+     *  - ̹ҽӵĹβС
+     */
+    bool growSegment(size_t localSegNo, ptrdiff_t deltaBytes);
+
+    /**
+     * ñضκ + ƫ 32/64λԭӲ(ͨڹ)
+     *  - ͬ MemoryManager Ӧӿ,offset 谴С
+     */
+    bool atomicCompareExchange(size_t localSegNo, uint32_t offset, uint32_t& expected, uint32_t desired, bool& exchanged);
+    bool atomicCompareExchange(size_t localSegNo, uint32_t offset, uint64_t& expected, uint64_t desired, bool& exchanged);
+    bool atomicFetchAdd(size_t localSegNo, uint32_t offset, uint32_t delta, uint32_t& previous);
+    bool atomicFetchAdd(size_t localSegNo, uint32_t offset, uint64_t delta, uint64_t& previous);
+    bool atomicExchange(size_t localSegNo, uint32_t offset, uint32_t value, uint32_t& previous);
+    bool atomicExchange(size_t localSegNo, uint32_t offset, uint64_t value, uint64_t& previous);
+
+    /**
+     * ñ̵פ֡ȼ:
+     *  - ޺,ȱҳֻԼҳ(ֲû)
+     *  - Ӧڴ˽ж֮ǰ,֮󴴽˽жΰ֡
+     */
+    void setResidentLimit(size_t maxFrames, int reclaimPriority = 0);
+
+    /**
+     * ѯ̵פͳ(פ֡ȱҳʵ)
+     */
+    ResidentSetStats getResidentSetStats() const;
+
     /**
      * ݱضκŻȡӦȫֶκ
      */
@@ -71,5 +124,6 @@ private:
     int pid;
     MemoryManager* mm;
     vector<size_t> segmentMap;    // ضκ -> ȫֶκ
+    vector<bool> attached;        // ضǷ attachSegment ӳ( detach ʱ)
     mutable mutex procMtx;        // segmentMapĲ
 };
@@ -1,5 +1,6 @@
+#pragma once
 #include <cstddef>
-#include <vector>
+#include <atomic>
 
 using namespace std;
 
@@ -10,35 +11,89 @@ struct SegmentDescriptor
 	size_t pageTableIndex;
 	bool shared;
 	size_t refCount;
+	bool growsDown;	// 栈式段: 合法偏移为 [top - limit, top),向低地址增长
+	size_t top;	// 栈式段的上界(页对齐),普通段为0
+	int owner;	// 驻留帧记账的进程ID,-1 表示不记账(如共享段)
+	size_t attachCount;	// 通过 Process::attachSegment 映射该段的次数
 
-	SegmentDescriptor(): valid(false),limit(0),pageTableIndex(0),shared(false),refCount(0){}
+	SegmentDescriptor(): valid(false),limit(0),pageTableIndex(0),shared(false),refCount(0),growsDown(false),top(0),owner(-1),attachCount(0){}
 };
 
+/**
+ * 段表
+ * 段表项按块分配且存储位置从不移动或释放:
+ *  - 第 b 块容纳 kFirstBucket << b 项,块数按段数对数增长,段表没有固定上限
+ *  - getSegment 返回的指针在段表生命周期内始终有效,不会因新增段而悬空
+ *  - 销毁段只置 valid=false,段号不复用
+ *  - 读取不需要加锁;新增段由调用者串行化(MemoryManager 持锁调用)
+ */
 class SegmentTable {
 public:
+	static const size_t kFirstBucket = 64;
+	static const size_t kMaxBuckets = 48;	// 可容纳 64 * (2^48 - 1) 项,实际不会用满
+
+	SegmentTable() : count(0) {
+		for (size_t i = 0; i < kMaxBuckets; ++i) {
+			buckets[i].store(nullptr);
+		}
+	}
+
+	~SegmentTable() {
+		for (size_t i = 0; i < kMaxBuckets; ++i) {
+			delete[] buckets[i].load();
+		}
+	}
+
+	SegmentTable(const SegmentTable&) = delete;
+	SegmentTable& operator=(const SegmentTable&) = delete;
+
 	const SegmentDescriptor* getSegment(size_t segNo) const {
-		if (segNo >= segments.size()) {
+		if (segNo >= count.load(memory_order_acquire)) {
 			return nullptr;
 		}
-		return &segments[segNo];
+		size_t index;
+		size_t b = bucketOf(segNo, index);
+		return &buckets[b].load(memory_order_acquire)[index];
 	}
 	
 	SegmentDescriptor* getSegment(size_t segNo) {
-		if (segNo >= segments.size()) {
-			return nullptr;
-		}
-		return &segments[segNo];
+		return const_cast<SegmentDescriptor*>(static_cast<const SegmentTable*>(this)->getSegment(segNo));
 	}
 
+	// 段表已满时返回 (size_t)-1
 	size_t addSegment(const SegmentDescriptor& desc) {
-		segments.push_back(desc);
-		return segments.size() - 1;
+		size_t segNo = count.load(memory_order_relaxed);
+		size_t index;
+		size_t b = bucketOf(segNo, index);
+		if (b >= kMaxBuckets) {
+			return static_cast<size_t>(-1);
+		}
+		SegmentDescriptor* bucket = buckets[b].load(memory_order_relaxed);
+		if (!bucket) {
+			bucket = new SegmentDescriptor[kFirstBucket << b];
+			buckets[b].store(bucket, memory_order_release);
+		}
+		bucket[index] = desc;
+		count.store(segNo + 1, memory_order_release);
+		return segNo;
 	}
 
 	size_t size() const {
-		return segments.size();
+		return count.load(memory_order_acquire);
 	}
 
 private:
-	vector<SegmentDescriptor> segments;
+	// 段号 -> (块号, 块内下标): 第 b 块从 kFirstBucket * (2^b - 1) 开始
+	static size_t bucketOf(size_t segNo, size_t& index) {
+		size_t q = segNo / kFirstBucket + 1;
+		size_t b = 0;
+		while (q >> (b + 1)) {
+			++b;
+		}
+		index = segNo - kFirstBucket * ((static_cast<size_t>(1) << b) - 1);
+		return b;
+	}
+
+	atomic<SegmentDescriptor*> buckets[kMaxBuckets];
+	atomic<size_t> count;
 };
@@ -13,33 +13,24 @@ size_t SharedMemoryManager::createOrGet(int key, size_t sizeBytes) {
     if (it != keyToSeg.end()) {
         // й,ü
         size_t globalSegNo = it->second;
-        SegmentDescriptor* seg = mm->getSegmentDescriptor(globalSegNo);
-        if (!seg || !seg->valid) {
+        size_t refCount;
+        if (!mm->retainSegment(globalSegNo, refCount)) {
             cerr << "[SharedMemoryManager] Existing segment invalid for key=" << key << endl;
             return static_cast<size_t>(-1);
         }
-        seg->refCount++;
         cout << "[SharedMemoryManager] Reuse shared segment: key=" << key
             << ", globalSegNo=" << globalSegNo
-            << ", refCount=" << seg->refCount << endl;
+            << ", refCount=" << refCount << endl;
         return globalSegNo;
     }
 
-    // ½
+    // ½(createSegment  shared=true, refCount=1)
     size_t globalSegNo = mm->createSegment(sizeBytes, true);
     if (globalSegNo == static_cast<size_t>(-1)) {
         cerr << "[SharedMemoryManager] Failed to create new shared segment for key=" << key << endl;
         return static_cast<size_t>(-1);
     }
 
-    SegmentDescriptor* seg = mm->getSegmentDescriptor(globalSegNo);
-    if (!seg) {
-        cerr << "[SharedMemoryManager] Created segment descriptor not found." << endl;
-        return static_cast<size_t>(-1);
-    }
-    seg->shared = true;
-    seg->refCount = 1;
-
     keyToSeg[key] = globalSegNo;
 
     cout << "[SharedMemoryManager] Created new shared segment: key=" << key
@@ -64,23 +55,17 @@ void SharedMemoryManager::detach(int key) {
     }
 
     size_t globalSegNo = it->second;
-    SegmentDescriptor* seg = mm->getSegmentDescriptor(globalSegNo);
-    if (!seg || !seg->valid) {
-        cerr << "[SharedMemoryManager] detach: invalid segment for key=" << key << endl;
-        return;
-    }
-
-    if (seg->refCount == 0) {
-        cerr << "[SharedMemoryManager] detach: refCount already 0 for key=" << key << endl;
+    size_t refCount;
+    if (!mm->releaseSegment(globalSegNo, refCount)) {
+        cerr << "[SharedMemoryManager] detach: invalid segment or refCount already 0 for key=" << key << endl;
         return;
     }
 
-    seg->refCount--;
     cout << "[SharedMemoryManager] detach key=" << key
         << ", globalSegNo=" << globalSegNo
-        << ", new refCount=" << seg->refCount << endl;
+        << ", new refCount=" << refCount << endl;
 
-    if (seg->refCount == 0) {
+    if (refCount == 0) {
         // ٶ
         if (mm->destroySegment(globalSegNo)) {
             cout << "[SharedMemoryManager] Segment destroyed for key=" << key << endl;
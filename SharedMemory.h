@@ -14,7 +14,7 @@ using namespace std;
  *  - ȫֶαе refCount
  *
  * ע:
- *  - refCount  SegmentDescriptor 
+ *  - refCount  SegmentDescriptor ,ͨ MemoryManager::retainSegment/releaseSegment ޸
  *  -  attach ͬһ key ʱ,ͬһȫֶ
  */
 class SharedMemoryManager {
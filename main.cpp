@@ -1,11 +1,111 @@
 #include <iostream>
 #include <thread>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
 #include "MemoryManager.h"
 #include "Process.h"
 #include "SharedMemory.h"
+#include "MessageQueue.h"
 
 using namespace std;
 
+/**
+ * 消息队列吞吐测试:
+ *  - pairs 对生产者/消费者进程,各自在私有段中准备/接收消息
+ *  - 生产者按 batch 条一批发送,消费者按 batch 条一批接收
+ * @return 每秒消息数
+ */
+static double benchmarkQueue(QueueKind kind, int pairs, size_t totalMessages, size_t batch) {
+    const uint32_t msgSize = 64;
+    MemoryManager mm(4096, 1024);
+    SharedMemoryManager shm(&mm);
+
+    vector<unique_ptr<Process>> procs;
+    vector<unique_ptr<MessageQueue>> queues;
+    vector<size_t> bufSegs;
+    for (int i = 0; i < pairs * 2; ++i) {
+        procs.emplace_back(new Process(100 + i, &mm));
+        bufSegs.push_back(procs.back()->createPrivateSegment(msgSize * batch));
+        // SPSC 每对一个队列,MPMC 所有进程共用一个队列
+        string name = kind == QueueKind::SPSC ? "bench-" + to_string(i / 2) : "bench-mpmc";
+        queues.emplace_back(new MessageQueue(&mm, &shm, procs.back().get(), name, kind, 1024, msgSize));
+    }
+
+    size_t perProducer = totalMessages / pairs;
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int i = 0; i < pairs * 2; ++i) {
+        threads.emplace_back([&, i]() {
+            vector<QueueMessage> msgs(batch);
+            vector<uint32_t> lengths(batch);
+            for (size_t j = 0; j < batch; ++j) {
+                msgs[j] = { bufSegs[i], static_cast<uint32_t>(j * msgSize), msgSize };
+            }
+            bool producer = i % 2 == 0;
+            size_t done = 0;
+            while (done < perProducer) {
+                size_t want = min(batch, perProducer - done);
+                size_t n = producer ? queues[i]->sendBatch(msgs.data(), want)
+                    : queues[i]->receiveBatch(msgs.data(), lengths.data(), want);
+                if (n == 0) {
+                    this_thread::yield();
+                }
+                done += n;
+            }
+            });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return perProducer * pairs / seconds;
+}
+
+/**
+ * 真实转换路径的测试: 在给定页大小的 MemoryManager 上调用 translateBatch
+ *  - 4096 字节页走 FixedPageGeometry<4096>,4000 字节页退化为 DivPageGeometry
+ *  - 两者用同样的页数、同样分布的随机地址,按批提交
+ *  - sink 累加物理地址,防止编译器把循环优化掉
+ * @return 每个地址的纳秒数
+ */
+static double benchmarkTranslate(size_t pageSize, size_t pages, int rounds, size_t& sink) {
+    MemoryManager mm(pageSize, pages);
+    size_t segNo = mm.createSegment(pages * pageSize);
+    if (segNo == static_cast<size_t>(-1)) {
+        return 0;
+    }
+
+    mt19937 rng(42);
+    uniform_int_distribution<uint32_t> dist(0, static_cast<uint32_t>(pages * pageSize - 1));
+    vector<LogicalAddress> las(1 << 16);
+    for (LogicalAddress& la : las) {
+        la.segment = static_cast<uint32_t>(segNo);
+        la.offset = dist(rng);
+    }
+
+    const size_t batch = 256;
+    vector<size_t> physical(batch);
+    vector<TranslateStatus> status(batch);
+    auto runRounds = [&](int n) {
+        for (int r = 0; r < n; ++r) {
+            for (size_t i = 0; i < las.size(); i += batch) {
+                size_t count = min(batch, las.size() - i);
+                sink += mm.translateBatch(&las[i], count, physical.data(), status.data());
+                sink += physical[count - 1];
+            }
+        }
+    };
+
+    runRounds(2);   // 预热
+    auto start = chrono::steady_clock::now();
+    runRounds(rounds);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return ns / (static_cast<double>(rounds) * las.size());
+}
 
 int main() {
     size_t pageSize = 1024;  
@@ -55,10 +155,94 @@ int main() {
         cout << "[Check] Process 2 failed to read offset 0 in shared segment." << endl;
     }
 
-    cout << "\n=== Detach shared memory and cleanup ===" << endl;
+    cout << "\n=== Lock-free counter on shared segment ===" << endl;
+
+    auto addMany = [](Process& p, size_t localSeg) {
+        for (int i = 0; i < 10000; ++i) {
+            uint64_t previous;
+            p.atomicFetchAdd(localSeg, 512, static_cast<uint64_t>(1), previous);  // 偏移512处的64位计数器
+        }
+        };
+    thread a1(addMany, ref(p1), p1SharedLocalSeg);
+    thread a2(addMany, ref(p2), p2SharedLocalSeg);
+    a1.join();
+    a2.join();
+
+    uint64_t counter = 0;
+    p1.atomicFetchAdd(p1SharedLocalSeg, 512, static_cast<uint64_t>(0), counter);
+    cout << "[Check] Shared counter after 2 x 10000 atomic adds: " << counter << endl;
+
+    cout << "\n=== Grow private segments in place ===" << endl;
+
+    p1.writeByte(p1PrivateSeg, 1999, 0x5A);
+    p1.growSegment(p1PrivateSeg, 3000);              // 类似 brk: 追加页,帧在首次写入时分配
+    p1.writeByte(p1PrivateSeg, 4500, 0xA5);
+    uint8_t heapOld = 0;
+    uint8_t heapNew = 0;
+    p1.readByte(p1PrivateSeg, 1999, heapOld);
+    p1.readByte(p1PrivateSeg, 4500, heapNew);
+    cout << "[Check] Process 1 heap after growth: old=0x" << hex << (int)heapOld
+        << " new=0x" << (int)heapNew << dec << endl;
+    p1.growSegment(p1PrivateSeg, -3000);             // 从尾部回收页
+
+    size_t p2StackSeg = p2.createStackSegment(1024, 8192);
+    p2.growSegment(p2StackSeg, 2048);                // 向低地址增长,已有数据偏移不变
+    p2.writeByte(p2StackSeg, 8192 - 3000, 0x7E);
+
+    bool sharedShrunk = p1.growSegment(p1SharedLocalSeg, -3000);    // p2 仍映射该段,应被拒绝
+    cout << "[Check] Shrink attached shared segment rejected: " << (sharedShrunk ? "no" : "yes") << endl;
+    p2.detachSegment(p2SharedLocalSeg);
+    p1.detachSegment(p1SharedLocalSeg);
+
     shm.detach(shmKey); 
     shm.detach(shmKey);
 
+    cout << "\n=== Resident-set limit with local replacement ===" << endl;
+    Process p3(3, &mm);
+    p3.setResidentLimit(4);                          // 最多驻留4帧,超出后只换出自己的页
+    size_t p3BigSeg = p3.createPrivateSegment(16 * pageSize);
+    for (int round = 0; round < 2; ++round) {
+        for (uint32_t off = 0; off < 16 * pageSize; off += static_cast<uint32_t>(pageSize)) {
+            p3.writeByte(p3BigSeg, off, static_cast<uint8_t>(off / pageSize));
+        }
+    }
+    ResidentSetStats rs3 = p3.getResidentSetStats();
+    cout << "[Check] Process 3 resident=" << rs3.residentFrames << "/" << rs3.limitFrames
+        << " faults=" << rs3.faults << " evictions=" << rs3.evictions
+        << " faultRate=" << rs3.faultRate << endl;
+
+    cout << "\n=== Compact physical frames ===" << endl;
+    FrameCompactionStats cs;
+    do {
+        cs = mm.compactFrames(chrono::microseconds(200));   // 每次最多暂停约200us
+        cout << "[Compact] moved " << cs.framesMoved << " frames (" << cs.bytesMoved
+            << " bytes), largest free run " << cs.largestFreeRunBefore << " -> "
+            << cs.largestFreeRunAfter << ", free runs " << cs.freeRunsBefore << " -> "
+            << cs.freeRunsAfter << endl;
+    } while (!cs.done);
+
+    cout << "\n=== Phase 3: Shared-memory message queue throughput ===" << endl;
+    streambuf* saved = cout.rdbuf(nullptr);          // 屏蔽建段/挂接日志
+    double spsc1 = benchmarkQueue(QueueKind::SPSC, 1, 200000, 32);
+    double spsc2 = benchmarkQueue(QueueKind::SPSC, 2, 200000, 32);
+    double mpmc2 = benchmarkQueue(QueueKind::MPMC, 2, 200000, 32);
+    cout.rdbuf(saved);
+    cout << "[Bench] SPSC, 1 pair : " << static_cast<size_t>(spsc1) << " msgs/s" << endl;
+    cout << "[Bench] SPSC, 2 pairs: " << static_cast<size_t>(spsc2) << " msgs/s" << endl;
+    cout << "[Bench] MPMC, 2 pairs: " << static_cast<size_t>(mpmc2) << " msgs/s" << endl;
+
+    cout << "\n=== Phase 3: Page geometry translation benchmark ===" << endl;
+    {
+        size_t sink = 0;
+        const size_t benchPages = 256;
+        const int rounds = 50;
+        double pow2Ns = benchmarkTranslate(4096, benchPages, rounds, sink);
+        double arbitraryNs = benchmarkTranslate(4000, benchPages, rounds, sink);
+        cout << "[Bench] translateBatch, 4096-byte pages: " << pow2Ns << " ns/address" << endl;
+        cout << "[Bench] translateBatch, 4000-byte pages: " << arbitraryNs << " ns/address" << endl;
+        cout << "[Bench] (checksum " << sink << ")" << endl;
+    }
+
     cout << "Program finished." << endl;
     return 0;
 }